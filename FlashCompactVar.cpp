@@ -0,0 +1,371 @@
+#include "FlashCompactVar.h"
+#include "util_crc32.h"
+
+FlashCompactVar::
+    FlashCompactVar(uint32_t start_addr,
+                    size_t memory_size,
+                    uint16_t page_erase_size,
+                    uint16_t data_length) : _start_addr(start_addr),
+                                            _memory_size(memory_size),
+                                            _page_erase_size(page_erase_size),
+                                            _data_length(data_length),
+                                            _slot_length(((COMPACT_HEADER_LENGTH + data_length + 3U) / 4U) * 4U),
+                                            _slot_per_page(page_erase_size / (((COMPACT_HEADER_LENGTH + data_length + 3U) / 4U) * 4U)),
+                                            _last_addr(COMPACT_SLOT_END),
+                                            _next_addr(start_addr),
+                                            _sequence(0),
+                                            _pSlot(nullptr)
+{
+    _pCallbacks = &defaultCallback;
+} // FlashCompactVar
+
+FlashCompactVar::~FlashCompactVar()
+{
+    delete[] _pSlot; /* free memory */
+} // ~FlashCompactVar
+
+/**
+ * @brief Set the callback handlers for this flash memory.
+ * @param [in] pCallbacks An instance of a callbacks structure used to define any callbacks for the flash memory.
+ */
+void FlashCompactVar::setCallbacks(FlashWearLevellingCallbacks *pCallbacks)
+{
+    if (pCallbacks != nullptr)
+    {
+        _pCallbacks = pCallbacks;
+    }
+    else
+    {
+        _pCallbacks = &defaultCallback;
+    }
+} // setCallbacks
+
+/**
+ * Find the newest slot, the page with newest sequence at the first slot is the current page
+*/
+bool FlashCompactVar::begin(bool formatOnFail)
+{
+    uint32_t addr, page_addr;
+    uint16_t lo, hi, mid, sequence;
+    bool blank;
+
+    if (!verifyMemInfo())
+    {
+        FCV_TAG_INFO("[begin] memory info Failed!");
+        return false;
+    }
+
+    if (_pSlot == nullptr)
+    {
+        _pSlot = new (std::nothrow) uint8_t[_slot_length];
+        if (_pSlot == nullptr)
+        {
+            FCV_TAG_INFO("[begin] Allocate RAM failed!");
+            return false;
+        }
+    }
+
+    /* One read per page */
+    page_addr = COMPACT_SLOT_END;
+    sequence = 0;
+    for (addr = _start_addr; addr < (_start_addr + _memory_size); addr += _page_erase_size)
+    {
+        if (loadSlot(addr, &blank))
+        {
+            uint16_t page_sequence = ((compact_header_t *)_pSlot)->sequence;
+            if ((COMPACT_SLOT_END == page_addr) || newerSequence(page_sequence, sequence))
+            {
+                page_addr = addr;
+                sequence = page_sequence;
+            }
+        }
+    }
+
+    if (COMPACT_SLOT_END == page_addr)
+    {
+        FCV_TAG_INFO("[begin] Not Found slot");
+        _last_addr = COMPACT_SLOT_END;
+        _next_addr = _start_addr;
+        _sequence = 0;
+        return formatOnFail ? format() : false;
+    }
+
+    /* The slots are written in order, binary search the last slot is not blank */
+    lo = 0;
+    hi = _slot_per_page - 1;
+    while (lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        if (!slotBlank(page_addr + mid * _slot_length, &blank))
+        {
+            return false;
+        }
+
+        if (blank)
+        {
+            hi = mid - 1;
+        }
+        else
+        {
+            lo = mid;
+        }
+    }
+
+    /* The newest valid slot, the last slot can be broken by a power lost */
+    _next_addr = page_addr + (lo + 1) * _slot_length;
+    if ((lo + 1) == _slot_per_page)
+    {
+        _next_addr = page_addr + _page_erase_size;
+        if (_next_addr >= (_start_addr + _memory_size))
+        {
+            _next_addr = _start_addr;
+        }
+    }
+
+    do
+    {
+        addr = page_addr + lo * _slot_length;
+        if (loadSlot(addr, &blank))
+        {
+            _last_addr = addr;
+            _sequence = ((compact_header_t *)_pSlot)->sequence;
+            break;
+        }
+    } while (lo-- > 0);
+
+    FCV_TAG_INFO("[begin] last %u(0x%X) next %u(0x%X) sequence %u", _last_addr, _last_addr, _next_addr, _next_addr, _sequence);
+    return true;
+} // begin
+
+/**
+ * Format memory type as factory, all pages not blank are erased
+*/
+bool FlashCompactVar::format()
+{
+    uint32_t addr, run_addr = COMPACT_SLOT_END;
+    bool blank;
+
+    /* The contiguous pages not blank are erased together */
+    for (addr = _start_addr; addr <= (_start_addr + _memory_size); addr += _page_erase_size)
+    {
+        if (addr < (_start_addr + _memory_size))
+        {
+            if (!slotBlank(addr, &blank))
+            {
+                return false;
+            }
+
+            if (!blank)
+            {
+                if (COMPACT_SLOT_END == run_addr)
+                {
+                    run_addr = addr;
+                }
+                continue;
+            }
+        }
+
+        if ((COMPACT_SLOT_END != run_addr) && !_pCallbacks->eraseRange(run_addr, addr - run_addr, _page_erase_size))
+        {
+            FCV_TAG_INFO("[format] erase failed!");
+            return false;
+        }
+        run_addr = COMPACT_SLOT_END;
+    }
+
+    _last_addr = COMPACT_SLOT_END;
+    _next_addr = _start_addr;
+    _sequence = 0;
+    return true;
+} // format
+
+/** Write data to the next slot, the page is erased at the first slot
+ *
+ *  @param buff     Buffer of data to write
+ *  @param length   Size to write in bytes, must be equal data length
+ *  @return         True if write is succeed
+ */
+bool FlashCompactVar::write(uint8_t *buff, uint32_t *length)
+{
+    compact_header_t *header = (compact_header_t *)_pSlot;
+    uint32_t write_length;
+    uint16_t sequence;
+
+    if ((_pSlot == nullptr) || (*length != _data_length))
+    {
+        FCV_TAG_INFO("[write] length failed!");
+        return false;
+    }
+
+    if (0 == ((_next_addr - _start_addr) % _page_erase_size))
+    {
+        FCV_TAG_INFO("[write] erase page %u(0x%X)", _next_addr, _next_addr);
+        if (!_pCallbacks->onErase(_next_addr, _page_erase_size))
+        {
+            FCV_TAG_INFO("[write] erase failed!");
+            return false;
+        }
+    }
+
+    /* The blank sequence is skipped */
+    sequence = _sequence + 1;
+    if (COMPACT_SEQUENCE_BLANK == sequence)
+    {
+        sequence = 0;
+    }
+
+    memset(_pSlot, 0xFF, _slot_length);
+    header->sequence = sequence;
+    memcpy(_pSlot + COMPACT_HEADER_LENGTH, buff, _data_length);
+    header->crc16 = slotCrc16(_pSlot);
+
+    write_length = _slot_length;
+    if (!_pCallbacks->onWrite(_next_addr, _pSlot, &write_length) || (write_length != _slot_length))
+    {
+        FCV_TAG_INFO("[write] write failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+        return false;
+    }
+
+    _last_addr = _next_addr;
+    _sequence = sequence;
+    _next_addr += _slot_length;
+    if ((((_last_addr - _start_addr) % _page_erase_size) / _slot_length + 1U) == _slot_per_page)
+    {
+        /* Next page */
+        _next_addr = _last_addr - ((_last_addr - _start_addr) % _page_erase_size) + _page_erase_size;
+    }
+
+    if (_next_addr >= (_start_addr + _memory_size))
+    {
+        _next_addr = _start_addr;
+    }
+
+    return true;
+} // write
+
+/** Read data of the newest slot
+ *
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if read is succeed
+ */
+bool FlashCompactVar::read(uint8_t *buff, uint32_t *length)
+{
+    bool blank;
+
+    if ((COMPACT_SLOT_END == _last_addr) || (*length < _data_length))
+    {
+        FCV_TAG_INFO("[read] no data or length buffer is not enough!");
+        return false;
+    }
+
+    if (!loadSlot(_last_addr, &blank))
+    {
+        FCV_TAG_INFO("[read] Data failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_DATA);
+        return false;
+    }
+
+    memcpy(buff, _pSlot + COMPACT_HEADER_LENGTH, _data_length);
+    *length = _data_length;
+    return true;
+} // read
+
+/**
+ * verify memory information
+*/
+bool FlashCompactVar::verifyMemInfo()
+{
+    if ((0 == _page_erase_size) || (_start_addr % _page_erase_size))
+    {
+        FCV_TAG_INFO("[verifyMemInfo][error] _start_addr must be multiples _page_erase_size");
+        return false;
+    }
+
+    if ((0 == _memory_size) || (_memory_size % _page_erase_size))
+    {
+        FCV_TAG_INFO("[verifyMemInfo][error] _memory_size must be multiples _page_erase_size");
+        return false;
+    }
+
+    if ((0 == _data_length) || (_data_length > COMPACT_LENGTH_MAX) || (0 == _slot_per_page))
+    {
+        FCV_TAG_INFO("[verifyMemInfo][error] _data_length failed!");
+        return false;
+    }
+
+    /* The sequence is compared in half of 16-bit range */
+    if (((_memory_size / _page_erase_size) * _slot_per_page) >= 0x8000U)
+    {
+        FCV_TAG_INFO("[verifyMemInfo][error] too many slots");
+        return false;
+    }
+
+    return true;
+} // verifyMemInfo
+
+/**
+ * @brief Low 16-bit of CRC32 over sequence and data of a slot.
+ */
+uint16_t FlashCompactVar::slotCrc16(uint8_t *slot)
+{
+    CRC32_Start(0);
+    CRC32_Accumulate(slot, sizeof(uint16_t));
+    CRC32_Accumulate(slot + COMPACT_HEADER_LENGTH, _data_length);
+    return (uint16_t)(CRC32_Get() & 0xFFFF);
+} // slotCrc16
+
+/**
+ * @brief Read a slot into _pSlot and verify it.
+ * @param [in] addr The address of slot.
+ * @param [out] blank The header of slot is blank.
+ */
+bool FlashCompactVar::loadSlot(uint32_t addr, bool *blank)
+{
+    compact_header_t *header = (compact_header_t *)_pSlot;
+    uint32_t length = _slot_length;
+
+    *blank = false;
+    if (!_pCallbacks->onRead(addr, _pSlot, &length) || (length != _slot_length))
+    {
+        FCV_TAG_INFO("[loadSlot] Read failed!");
+        return false;
+    }
+
+    if ((COMPACT_SEQUENCE_BLANK == header->sequence) && (0xFFFF == header->crc16))
+    {
+        *blank = true;
+        return false;
+    }
+
+    return (COMPACT_SEQUENCE_BLANK != header->sequence) && (slotCrc16(_pSlot) == header->crc16);
+} // loadSlot
+
+/**
+ * @brief Read only the header of a slot.
+ * @param [in] addr The address of slot.
+ * @param [out] blank The header of slot is blank.
+ */
+bool FlashCompactVar::slotBlank(uint32_t addr, bool *blank)
+{
+    compact_header_t header;
+    uint32_t length = COMPACT_HEADER_LENGTH;
+
+    if (!_pCallbacks->onRead(addr, (uint8_t *)&header, &length) || (length != COMPACT_HEADER_LENGTH))
+    {
+        FCV_TAG_INFO("[slotBlank] Read failed!");
+        return false;
+    }
+
+    *blank = (COMPACT_SEQUENCE_BLANK == header.sequence) && (0xFFFF == header.crc16);
+    return true;
+} // slotBlank
+
+/**
+ * @brief Sequence a is written after b.
+ */
+bool FlashCompactVar::newerSequence(uint16_t a, uint16_t b)
+{
+    return (int16_t)(a - b) > 0;
+} // newerSequence
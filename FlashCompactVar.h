@@ -0,0 +1,92 @@
+/** @file FlashCompactVar.h
+ *  @brief utility support saving a small fixed length variable with a compact
+ *         4-byte header into a space NAND/NOR memory
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_COMPACT_VAR_H
+#define __FLASH_COMPACT_VAR_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define FCV_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FCV]", __VA_ARGS__)
+
+/**
+ * Each page is split into slots of (header + data) rounded up to 4-byte, a slot never
+ * cross a page. The address of record is implied by the slot index, so the header have
+ * only a sequence and a CRC16 (low 16-bit of CRC32 over sequence and data).
+ * A data of 4-byte or less fit a 8-byte slot, compared with 20-byte by FlashWearLevellingUtils.
+ */
+class FlashCompactVar
+{
+    typedef enum
+    {
+        COMPACT_HEADER_LENGTH = 4,
+        COMPACT_LENGTH_MAX = 256,
+        COMPACT_SEQUENCE_BLANK = 0xFFFF,
+        COMPACT_SLOT_END = 0xFFFFFFFF
+    } compactType_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint16_t sequence;
+        uint16_t crc16;
+    } compact_header_t;
+
+public:
+    FlashCompactVar(uint32_t start_addr = 0,
+                    size_t memory_size = MEMORY_SIZE_DEFAULT,
+                    uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT,
+                    uint16_t data_length = 4);
+    ~FlashCompactVar();
+    void setCallbacks(FlashWearLevellingCallbacks *pCallbacks);
+    bool begin(bool formatOnFail = false);
+    bool format();
+    bool write(uint8_t *buff, uint32_t *length);
+    bool read(uint8_t *buff, uint32_t *length);
+
+    template <typename varType>
+    bool write(varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        return write((uint8_t *)data, &length) && (length == sizeof(varType));
+    } // write
+
+    template <typename varType>
+    bool read(varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        return read((uint8_t *)data, &length) && (length == sizeof(varType));
+    } // read
+
+private:
+    const uint32_t _start_addr;
+    const size_t _memory_size;
+    const uint16_t _page_erase_size;
+    const uint16_t _data_length;
+    const uint16_t _slot_length;
+    const uint16_t _slot_per_page;
+    uint32_t _last_addr; /* COMPACT_SLOT_END if no data */
+    uint32_t _next_addr;
+    uint16_t _sequence;
+    uint8_t *_pSlot;
+    FlashWearLevellingCallbacks *_pCallbacks;
+    bool verifyMemInfo();
+    uint16_t slotCrc16(uint8_t *slot);
+    bool loadSlot(uint32_t addr, bool *blank);
+    bool slotBlank(uint32_t addr, bool *blank);
+    bool newerSequence(uint16_t a, uint16_t b);
+};
+
+#endif
@@ -0,0 +1,341 @@
+#include "FlashCounter.h"
+#include "util_crc32.h"
+
+FlashCounter::
+    FlashCounter(uint32_t start_addr,
+                 size_t memory_size,
+                 uint16_t page_erase_size) : _start_addr(start_addr),
+                                             _memory_size(memory_size),
+                                             _page_erase_size(page_erase_size),
+                                             _bit_per_page((page_erase_size > COUNTER_HEADER_LENGTH) ? (((page_erase_size - COUNTER_HEADER_LENGTH) / COUNTER_WORD_LENGTH) * 32U) : 0),
+                                             _page_addr(COUNTER_PAGE_NONE),
+                                             _base(0),
+                                             _sequence(0),
+                                             _bit_cnt(0)
+{
+    _pCallbacks = &defaultCallback;
+} // FlashCounter
+
+FlashCounter::~FlashCounter()
+{
+} // ~FlashCounter
+
+/**
+ * @brief Set the callback handlers for this flash memory.
+ * @param [in] pCallbacks An instance of a callbacks structure used to define any callbacks for the flash memory.
+ */
+void FlashCounter::setCallbacks(FlashWearLevellingCallbacks *pCallbacks)
+{
+    if (pCallbacks != nullptr)
+    {
+        _pCallbacks = pCallbacks;
+    }
+    else
+    {
+        _pCallbacks = &defaultCallback;
+    }
+} // setCallbacks
+
+/**
+ * Find the page with the newest base record, one read per page, then binary search
+ * the first word of bitmap is not cleared
+*/
+bool FlashCounter::begin(bool formatOnFail)
+{
+    counter_header_t header;
+    uint32_t addr;
+    bool blank;
+
+    if (!verifyMemInfo())
+    {
+        FCN_TAG_INFO("[begin] memory info Failed!");
+        return false;
+    }
+
+    _page_addr = COUNTER_PAGE_NONE;
+    for (addr = _start_addr; addr < (_start_addr + _memory_size); addr += _page_erase_size)
+    {
+        if (loadHeader(addr, &header, &blank)
+            && ((COUNTER_PAGE_NONE == _page_addr) || ((int32_t)(header.sequence - _sequence) > 0)))
+        {
+            _page_addr = addr;
+            _base = header.base;
+            _sequence = header.sequence;
+        }
+    }
+
+    if (COUNTER_PAGE_NONE == _page_addr)
+    {
+        FCN_TAG_INFO("[begin] Not Found base record");
+        return formatOnFail ? format() : false;
+    }
+
+    if (!countBits())
+    {
+        _page_addr = COUNTER_PAGE_NONE;
+        return false;
+    }
+
+    FCN_TAG_INFO("[begin] page %u(0x%X) base %u bits %u", _page_addr, _page_addr, _base, _bit_cnt);
+    return true;
+} // begin
+
+/**
+ * Format memory type as factory, the base record of value 0 is written in the first page
+*/
+bool FlashCounter::format()
+{
+    counter_header_t header;
+    uint32_t addr, run_addr = COUNTER_PAGE_NONE;
+    bool blank;
+
+    if (!verifyMemInfo())
+    {
+        return false;
+    }
+
+    /* The bitmap is written only after the base record, a page with blank header is blank.
+        The contiguous pages not blank are erased together */
+    for (addr = _start_addr; addr <= (_start_addr + _memory_size); addr += _page_erase_size)
+    {
+        if (addr < (_start_addr + _memory_size))
+        {
+            loadHeader(addr, &header, &blank);
+            if (!blank)
+            {
+                if (COUNTER_PAGE_NONE == run_addr)
+                {
+                    run_addr = addr;
+                }
+                continue;
+            }
+        }
+
+        if ((COUNTER_PAGE_NONE != run_addr) && !_pCallbacks->eraseRange(run_addr, addr - run_addr, _page_erase_size))
+        {
+            FCN_TAG_INFO("[format] erase failed!");
+            _page_addr = COUNTER_PAGE_NONE;
+            return false;
+        }
+        run_addr = COUNTER_PAGE_NONE;
+    }
+
+    return writeBase(_start_addr, 0, 0, false);
+} // format
+
+/** Add n to the value, the next n bits of bitmap are cleared. A base record is
+ *  written in the next page if the bitmap is not enough.
+ *
+ *  @param n        The number to add
+ *  @return         True if write is succeed
+ */
+bool FlashCounter::increment(uint32_t n)
+{
+    uint32_t bit, end, index, word, length, next_addr;
+
+    if ((COUNTER_PAGE_NONE == _page_addr) || (n > (UINT32_MAX - value())))
+    {
+        FCN_TAG_INFO("[increment] no base record or overflow!");
+        return false;
+    }
+
+    if (n > (_bit_per_page - _bit_cnt))
+    {
+        next_addr = _page_addr + _page_erase_size;
+        if (next_addr >= (_start_addr + _memory_size))
+        {
+            next_addr = _start_addr;
+        }
+        return writeBase(next_addr, value() + n, _sequence + 1U, true);
+    }
+
+    /* One word program per word of the bits */
+    for (bit = _bit_cnt; bit < (_bit_cnt + n); bit = end)
+    {
+        index = bit / 32U;
+        end = (index + 1U) * 32U;
+        if (end > (_bit_cnt + n))
+        {
+            end = _bit_cnt + n;
+        }
+        word = ((end % 32U) == 0) ? 0 : (0xFFFFFFFFU << (end % 32U));
+
+        length = COUNTER_WORD_LENGTH;
+        if (!_pCallbacks->onWrite(_page_addr + COUNTER_HEADER_LENGTH + index * COUNTER_WORD_LENGTH, (uint8_t *)&word, &length)
+            || (length != COUNTER_WORD_LENGTH))
+        {
+            FCN_TAG_INFO("[increment] write failed!");
+            _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+            _bit_cnt = bit;
+            return false;
+        }
+    }
+
+    _bit_cnt += n;
+    return true;
+} // increment
+
+/**
+ * Return the value, 0 if there is no base record
+*/
+uint32_t FlashCounter::value()
+{
+    return (COUNTER_PAGE_NONE == _page_addr) ? 0 : (_base + _bit_cnt);
+} // value
+
+/**
+ * verify memory information
+*/
+bool FlashCounter::verifyMemInfo()
+{
+    if ((0 == _page_erase_size) || (_start_addr % _page_erase_size))
+    {
+        FCN_TAG_INFO("[verifyMemInfo][error] _start_addr must be multiples _page_erase_size");
+        return false;
+    }
+
+    /* The base record of the next page is written before the newest page is erased */
+    if ((_memory_size < (2U * _page_erase_size)) || (_memory_size % _page_erase_size))
+    {
+        FCN_TAG_INFO("[verifyMemInfo][error] _memory_size must be 2 pages at least");
+        return false;
+    }
+
+    if ((_page_erase_size % COUNTER_WORD_LENGTH) || (0 == _bit_per_page))
+    {
+        FCN_TAG_INFO("[verifyMemInfo][error] _page_erase_size failed!");
+        return false;
+    }
+
+    return true;
+} // verifyMemInfo
+
+/**
+ * @brief Read and verify the base record of a page.
+ * @param [in] page_addr The address of page.
+ * @param [out] header The base record.
+ * @param [out] blank The base record is blank.
+ */
+bool FlashCounter::loadHeader(uint32_t page_addr, counter_header_t *header, bool *blank)
+{
+    uint32_t length = COUNTER_HEADER_LENGTH;
+
+    *blank = false;
+    if (!_pCallbacks->onRead(page_addr, (uint8_t *)header, &length) || (length != COUNTER_HEADER_LENGTH))
+    {
+        FCN_TAG_INFO("[loadHeader] Read failed!");
+        return false;
+    }
+
+    if ((0xFFFFFFFF == header->base) && (0xFFFFFFFF == header->sequence) && (0xFFFFFFFF == header->crc32))
+    {
+        *blank = true;
+        return false;
+    }
+
+    return headerCrc32(header) == header->crc32;
+} // loadHeader
+
+/**
+ * @brief Read a word of the bitmap of a page.
+ */
+bool FlashCounter::loadWord(uint32_t page_addr, uint32_t index, uint32_t *word)
+{
+    uint32_t length = COUNTER_WORD_LENGTH;
+
+    if (!_pCallbacks->onRead(page_addr + COUNTER_HEADER_LENGTH + index * COUNTER_WORD_LENGTH, (uint8_t *)word, &length)
+        || (length != COUNTER_WORD_LENGTH))
+    {
+        FCN_TAG_INFO("[loadWord] Read failed!");
+        return false;
+    }
+
+    return true;
+} // loadWord
+
+/**
+ * @brief The words cleared are followed by a word partly cleared, binary search it
+ *        and count the bits cleared of it.
+ */
+bool FlashCounter::countBits()
+{
+    uint32_t lo = 0, hi = _bit_per_page / 32U, mid, word;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2U;
+        if (!loadWord(_page_addr, mid, &word))
+        {
+            return false;
+        }
+
+        if (0 == word)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    _bit_cnt = lo * 32U;
+    if (lo < (_bit_per_page / 32U))
+    {
+        if (!loadWord(_page_addr, lo, &word))
+        {
+            return false;
+        }
+        _bit_cnt += 32U - __builtin_popcount(word);
+    }
+
+    return true;
+} // countBits
+
+/**
+ * @brief Write the base record of a page, the bitmap of it is blank.
+ * @param [in] page_addr The address of page.
+ * @param [in] base The value.
+ * @param [in] sequence The sequence of page.
+ * @param [in] erase Erase the page before.
+ */
+bool FlashCounter::writeBase(uint32_t page_addr, uint32_t base, uint32_t sequence, bool erase)
+{
+    counter_header_t header;
+    uint32_t length;
+
+    if (erase && !_pCallbacks->onErase(page_addr, _page_erase_size))
+    {
+        FCN_TAG_INFO("[writeBase] erase failed!");
+        return false;
+    }
+
+    header.base = base;
+    header.sequence = sequence;
+    header.crc32 = headerCrc32(&header);
+
+    length = COUNTER_HEADER_LENGTH;
+    if (!_pCallbacks->onWrite(page_addr, (uint8_t *)&header, &length) || (length != COUNTER_HEADER_LENGTH))
+    {
+        FCN_TAG_INFO("[writeBase] write failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+        return false;
+    }
+
+    FCN_TAG_INFO("[writeBase] page %u(0x%X) base %u sequence %u", page_addr, page_addr, base, sequence);
+    _page_addr = page_addr;
+    _base = base;
+    _sequence = sequence;
+    _bit_cnt = 0;
+    return true;
+} // writeBase
+
+/**
+ * @brief CRC32 over base and sequence.
+ */
+uint32_t FlashCounter::headerCrc32(counter_header_t *header)
+{
+    CRC32_Start(0);
+    CRC32_Accumulate((uint8_t *)header, COUNTER_HEADER_LENGTH - sizeof(uint32_t));
+    return CRC32_Get();
+} // headerCrc32
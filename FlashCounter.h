@@ -0,0 +1,80 @@
+/** @file FlashCounter.h
+ *  @brief utility support a monotonic counter by clearing bits of a pre-erased
+ *         bitmap into a space NOR memory
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_COUNTER_H
+#define __FLASH_COUNTER_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define FCN_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FCN]", __VA_ARGS__)
+
+/**
+ * Each page have a base record (base value, sequence, CRC32) then a bitmap, the value is
+ * the base of the newest page + the bits cleared of its bitmap. The bits are cleared from
+ * the first word and from the bit 0 of a word, an increment program only the word of the bit.
+ * The memory must allow a word programmed again to clear more bits (NOR).
+ * The page is full, the next page is erased and its base record is the value.
+ * Example: a page of 4KB count 32672 increments per erase.
+ */
+class FlashCounter
+{
+    typedef enum
+    {
+        COUNTER_HEADER_LENGTH = 12,
+        COUNTER_WORD_LENGTH = 4,
+        COUNTER_PAGE_NONE = 0xFFFFFFFF
+    } counterType_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t base;
+        uint32_t sequence;
+        uint32_t crc32; /* base and sequence */
+    } counter_header_t;
+
+public:
+    FlashCounter(uint32_t start_addr = 0,
+                 size_t memory_size = 2 * MEMORY_SIZE_DEFAULT,
+                 uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT);
+    ~FlashCounter();
+    void setCallbacks(FlashWearLevellingCallbacks *pCallbacks);
+    bool begin(bool formatOnFail = false);
+    /* All pages not blank are erased, the value is 0 */
+    bool format();
+    /* False if the value overflow */
+    bool increment(uint32_t n = 1);
+    uint32_t value();
+
+private:
+    const uint32_t _start_addr;
+    const size_t _memory_size;
+    const uint16_t _page_erase_size;
+    const uint32_t _bit_per_page;
+    uint32_t _page_addr; /* the newest page, COUNTER_PAGE_NONE if no base record */
+    uint32_t _base;
+    uint32_t _sequence;
+    uint32_t _bit_cnt; /* the bits cleared of the newest page */
+    FlashWearLevellingCallbacks *_pCallbacks;
+    bool verifyMemInfo();
+    bool loadHeader(uint32_t page_addr, counter_header_t *header, bool *blank);
+    bool loadWord(uint32_t page_addr, uint32_t index, uint32_t *word);
+    bool countBits();
+    bool writeBase(uint32_t page_addr, uint32_t base, uint32_t sequence, bool erase);
+    uint32_t headerCrc32(counter_header_t *header);
+};
+
+#endif
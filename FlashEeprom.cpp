@@ -0,0 +1,326 @@
+#include "FlashEeprom.h"
+
+FlashEeprom::FlashEeprom(uint32_t start_addr,
+                         size_t memory_size,
+                         uint16_t page_erase_size,
+                         uint16_t eeprom_size) : FlashWearLevellingUtils(start_addr,
+                                                                         memory_size,
+                                                                         page_erase_size,
+                                                                         MEMORY_LENGTH_MAX),
+                                                 _eeprom_size(eeprom_size),
+                                                 _pMirror(nullptr),
+                                                 _pScratch(nullptr),
+                                                 _snapshot_addr(start_addr),
+                                                 _pending_addr(MEMORY_HEADER_END),
+                                                 _pending_end(0)
+{
+    /* The mirror is built by the history */
+    _inPlace_isAllowed = false;
+} // FlashEeprom
+
+FlashEeprom::~FlashEeprom()
+{
+    delete[] _pMirror;  /* free memory */
+    delete[] _pScratch; /* free memory */
+} // ~FlashEeprom
+
+/**
+ * Find the last header and replay the records into the mirror, the oldest first
+*/
+bool FlashEeprom::begin(bool formatOnFail)
+{
+    if (!allocate())
+    {
+        FEE_TAG_INFO("[begin] Allocate RAM failed!");
+        return false;
+    }
+
+    if (!FlashWearLevellingUtils::begin(formatOnFail))
+    {
+        FEE_TAG_INFO("[begin] memory failed!");
+        return false;
+    }
+
+    memset(_pMirror, 0xFF, _eeprom_size);
+    _snapshot_addr = MEMORY_HEADER_END;
+    _pending_addr = MEMORY_HEADER_END;
+    if (!history(historyVisitor_t(this, &FlashEeprom::replayRecord), UINT32_MAX, true))
+    {
+        FEE_TAG_INFO("[begin] history failed!");
+        return false;
+    }
+
+    /* No record, the log start at the next header */
+    if (MEMORY_HEADER_END == _snapshot_addr)
+    {
+        _snapshot_addr = _memory_cxt.header.nextAddr;
+    }
+
+    FEE_TAG_INFO("[begin] snapshot Addr %u(0x%X)", _snapshot_addr, _snapshot_addr);
+    return true;
+} // begin
+
+/**
+ * Format memory type as factory, all bytes are 0xFF
+*/
+bool FlashEeprom::format()
+{
+    if ((_pMirror == nullptr) || !FlashWearLevellingUtils::format())
+    {
+        return false;
+    }
+
+    headerDefault();
+    memset(_pMirror, 0xFF, _eeprom_size);
+    _snapshot_addr = _memory_cxt.header.nextAddr;
+    return true;
+} // format
+
+/**
+ * Read a byte from the mirror
+*/
+uint8_t FlashEeprom::read(uint16_t vaddr)
+{
+    if ((_pMirror == nullptr) || (vaddr >= _eeprom_size))
+    {
+        return 0xFF;
+    }
+
+    return _pMirror[vaddr];
+} // read
+
+/** Read the bytes from the mirror
+ *
+ *  @param vaddr    The virtual address of the first byte
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if the bytes are in EEPROM
+ */
+bool FlashEeprom::read(uint16_t vaddr, uint8_t *buff, uint16_t length)
+{
+    if ((_pMirror == nullptr) || (((uint32_t)vaddr + length) > _eeprom_size))
+    {
+        FEE_TAG_INFO("[read] vaddr %u length %u failed!", vaddr, length);
+        return false;
+    }
+
+    memcpy(buff, _pMirror + vaddr, length);
+    return true;
+} // read
+
+bool FlashEeprom::write(uint16_t vaddr, uint8_t value)
+{
+    return write(vaddr, &value, 1);
+} // write
+
+/** Write the bytes, only the range from the first to the last byte changed is written,
+ *  a record per EEPROM_CHUNK_MAX byte
+ *
+ *  @param vaddr    The virtual address of the first byte
+ *  @param buff     Buffer of data to write
+ *  @param length   Size to write in bytes
+ *  @return         True if write is succeed
+ */
+bool FlashEeprom::write(uint16_t vaddr, const uint8_t *buff, uint16_t length)
+{
+    uint16_t chunk;
+
+    if ((_pMirror == nullptr) || (0 == length) || (((uint32_t)vaddr + length) > _eeprom_size))
+    {
+        FEE_TAG_INFO("[write] vaddr %u length %u failed!", vaddr, length);
+        return false;
+    }
+
+    while ((length > 0) && (_pMirror[vaddr] == buff[0]))
+    {
+        ++vaddr;
+        ++buff;
+        --length;
+    }
+    while ((length > 0) && (_pMirror[vaddr + length - 1] == buff[length - 1]))
+    {
+        --length;
+    }
+
+    while (length > 0)
+    {
+        chunk = (length > EEPROM_CHUNK_MAX) ? (uint16_t)EEPROM_CHUNK_MAX : length;
+        if (!compact(_header2data_offset_length + EEPROM_VADDR_LENGTH + chunk)
+            || !append(vaddr, buff, chunk, false))
+        {
+            FEE_TAG_INFO("[write] vaddr %u failed!", vaddr);
+            return false;
+        }
+
+        memcpy(_pMirror + vaddr, buff, chunk);
+        vaddr += chunk;
+        buff += chunk;
+        length -= chunk;
+    }
+
+    return true;
+} // write
+
+/**
+ * Return the EEPROM size in bytes
+*/
+uint16_t FlashEeprom::size()
+{
+    return _eeprom_size;
+} // size
+
+/**
+ * @brief Allocate the mirror and the scratch buffer a record.
+ */
+bool FlashEeprom::allocate()
+{
+    if ((0 == _eeprom_size) || (_eeprom_size > EEPROM_SIZE_MAX))
+    {
+        FEE_TAG_INFO("[allocate] EEPROM size failed!");
+        return false;
+    }
+
+    /* The next record, a wrap and the erase ahead must not reach the newest snapshot */
+    if (_memory_size < (_page_erase_size + 2 * (snapshotLength() + 2 * (_header2data_offset_length + MEMORY_LENGTH_MAX))))
+    {
+        FEE_TAG_INFO("[allocate] memory size is not enough");
+        return false;
+    }
+
+    if (_pMirror == nullptr)
+    {
+        _pMirror = new (std::nothrow) uint8_t[_eeprom_size];
+    }
+
+    if (_pScratch == nullptr)
+    {
+        _pScratch = new (std::nothrow) uint8_t[MEMORY_LENGTH_MAX];
+    }
+
+    return (_pMirror != nullptr) && (_pScratch != nullptr);
+} // allocate
+
+/**
+ * @brief Length of headers and data of a snapshot.
+ */
+uint32_t FlashEeprom::snapshotLength()
+{
+    uint32_t chunk_cnt = (_eeprom_size + EEPROM_CHUNK_MAX - 1) / EEPROM_CHUNK_MAX;
+
+    return chunk_cnt * (_header2data_offset_length + EEPROM_VADDR_LENGTH) + _eeprom_size;
+} // snapshotLength
+
+/**
+ * @brief history visitor, copy the values into the mirror and find the newest complete snapshot.
+ * @param [in] memory_cxt_t The record, oldest first.
+ */
+bool FlashEeprom::replayRecord(const memory_cxt_t *mem)
+{
+    uint16_t vaddr, length;
+
+    /* The oldest record is the start of log until a snapshot is complete */
+    if (MEMORY_HEADER_END == _snapshot_addr)
+    {
+        _snapshot_addr = mem->header.addr;
+    }
+
+    if ((MEMORY_HEADER_TYPE != mem->header.type) || (mem->data.length <= EEPROM_VADDR_LENGTH))
+    {
+        _pending_addr = MEMORY_HEADER_END;
+        return true;
+    }
+
+    vaddr = mem->data.pBuffer[0] | (mem->data.pBuffer[1] << 8);
+    length = mem->data.length - EEPROM_VADDR_LENGTH;
+    if (vaddr & EEPROM_SNAPSHOT_FLAG)
+    {
+        vaddr &= ~EEPROM_SNAPSHOT_FLAG;
+        _pending_addr = mem->header.addr;
+        _pending_end = 0;
+    }
+
+    if (((uint32_t)vaddr + length) > _eeprom_size)
+    {
+        FEE_TAG_INFO("[replayRecord] vaddr %u length %u failed!", vaddr, length);
+        _pending_addr = MEMORY_HEADER_END;
+        return true;
+    }
+    memcpy(_pMirror + vaddr, mem->data.pBuffer + EEPROM_VADDR_LENGTH, length);
+
+    /* The records of a snapshot are written back to back */
+    if ((MEMORY_HEADER_END != _pending_addr) && (vaddr == _pending_end))
+    {
+        _pending_end += length;
+        if (_pending_end == _eeprom_size)
+        {
+            _snapshot_addr = _pending_addr;
+            _pending_addr = MEMORY_HEADER_END;
+        }
+    }
+    else
+    {
+        _pending_addr = MEMORY_HEADER_END;
+    }
+
+    return true;
+} // replayRecord
+
+/**
+ * @brief Write a record of the bytes from a virtual address.
+ * @param [in] vaddr The virtual address.
+ * @param [in] buff The values.
+ * @param [in] length The length of values, EEPROM_CHUNK_MAX at most.
+ * @param [in] snapshot The first record of a snapshot.
+ */
+bool FlashEeprom::append(uint16_t vaddr, const uint8_t *buff, uint16_t length, bool snapshot)
+{
+    uint32_t data_length = EEPROM_VADDR_LENGTH + length;
+
+    if (snapshot)
+    {
+        vaddr |= EEPROM_SNAPSHOT_FLAG;
+    }
+
+    _pScratch[0] = vaddr & 0xFF;
+    _pScratch[1] = vaddr >> 8;
+    memcpy(_pScratch + EEPROM_VADDR_LENGTH, buff, length);
+    return FlashWearLevellingUtils::write(_pScratch, &data_length)
+           && (data_length == (uint32_t)(EEPROM_VADDR_LENGTH + length));
+} // append
+
+/**
+ * @brief Write a snapshot of the mirror if the record of length and the next snapshot
+ *        are not enough before the page of the newest snapshot is erased.
+ * @param [in] length The length of header and data of the next record.
+ */
+bool FlashEeprom::compact(uint32_t length)
+{
+    uint32_t used, snapshot_addr = MEMORY_HEADER_END;
+    uint16_t vaddr, chunk;
+
+    used = (_memory_cxt.header.nextAddr + _memory_size - _snapshot_addr) % _memory_size;
+    /* A wrap skip a record at most, the page after the next header is erased */
+    if ((used + length + (_header2data_offset_length + MEMORY_LENGTH_MAX) + snapshotLength() + _page_erase_size) <= _memory_size)
+    {
+        return true;
+    }
+
+    FEE_TAG_INFO("[compact] used %u", used);
+    for (vaddr = 0; vaddr < _eeprom_size; vaddr += chunk)
+    {
+        chunk = ((_eeprom_size - vaddr) > EEPROM_CHUNK_MAX) ? EEPROM_CHUNK_MAX : (_eeprom_size - vaddr);
+        if (!append(vaddr, _pMirror + vaddr, chunk, (0 == vaddr)))
+        {
+            FEE_TAG_INFO("[compact] write failed!");
+            return false;
+        }
+
+        if (0 == vaddr)
+        {
+            snapshot_addr = _memory_cxt.header.addr;
+        }
+    }
+
+    _snapshot_addr = snapshot_addr;
+    return true;
+} // compact
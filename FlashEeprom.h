@@ -0,0 +1,93 @@
+/** @file FlashEeprom.h
+ *  @brief utility support a byte-addressable EEPROM emulated by the records of
+ *         (virtual address, value) into one wear levelling memory region
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_EEPROM_H
+#define __FLASH_EEPROM_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define EEPROM_SIZE_DEFAULT 256U /* 256-Byte */
+
+#define FEE_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FEE]", __VA_ARGS__)
+
+/**
+ * The record data of EEPROM: virtual address (2-byte) + values of the bytes from it.
+ * Only the bytes changed are written, the values are kept in a RAM mirror and read in O(1).
+ *
+ * A snapshot is the mirror written as records from the virtual address 0, the first record
+ * have EEPROM_SNAPSHOT_FLAG. The snapshot is written before the log erase the page of
+ * the newest complete snapshot, the mount replay the records from the oldest.
+ * Example: 256-Byte EEPROM need 2 pages of 4KB.
+ */
+class FlashEeprom : protected FlashWearLevellingUtils
+{
+    typedef enum
+    {
+        EEPROM_VADDR_LENGTH = 2,
+        EEPROM_SNAPSHOT_FLAG = 0x8000, /* the first record of a snapshot */
+        EEPROM_CHUNK_MAX = MEMORY_LENGTH_MAX - EEPROM_VADDR_LENGTH,
+        EEPROM_SIZE_MAX = 0x7FFF
+    } eepromType_t;
+
+public:
+    FlashEeprom(uint32_t start_addr = 0,
+                size_t memory_size = 2 * MEMORY_SIZE_DEFAULT,
+                uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT,
+                uint16_t eeprom_size = EEPROM_SIZE_DEFAULT);
+    ~FlashEeprom();
+
+    using FlashWearLevellingUtils::setCallbacks;
+    using FlashWearLevellingUtils::stats;
+    using FlashWearLevellingUtils::resetStats;
+    using FlashWearLevellingUtils::writeAmplification;
+    using FlashWearLevellingUtils::lifetime;
+    bool begin(bool formatOnFail = false);
+    bool format();
+    /* 0xFF if the virtual address is out of EEPROM or never written */
+    uint8_t read(uint16_t vaddr);
+    bool read(uint16_t vaddr, uint8_t *buff, uint16_t length);
+    bool write(uint16_t vaddr, uint8_t value);
+    bool write(uint16_t vaddr, const uint8_t *buff, uint16_t length);
+    uint16_t size();
+
+    template <typename varType>
+    bool get(uint16_t vaddr, varType *data)
+    {
+        return read(vaddr, (uint8_t *)data, sizeof(varType));
+    } // get
+
+    template <typename varType>
+    bool put(uint16_t vaddr, const varType *data)
+    {
+        return write(vaddr, (const uint8_t *)data, sizeof(varType));
+    } // put
+
+private:
+    const uint16_t _eeprom_size;
+    uint8_t *_pMirror;
+    uint8_t *_pScratch;
+    uint32_t _snapshot_addr; /* header address of the first record of the newest complete snapshot */
+    uint32_t _pending_addr;  /* the snapshot replayed, MEMORY_HEADER_END if none */
+    uint16_t _pending_end;
+    bool allocate();
+    uint32_t snapshotLength();
+    bool replayRecord(const memory_cxt_t *mem);
+    bool append(uint16_t vaddr, const uint8_t *buff, uint16_t length, bool snapshot);
+    bool compact(uint32_t length);
+};
+
+#endif
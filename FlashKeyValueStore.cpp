@@ -0,0 +1,530 @@
+#include "FlashKeyValueStore.h"
+
+FlashKeyValueStore::
+    FlashKeyValueStore(uint32_t start_addr,
+                       size_t memory_size,
+                       uint16_t page_erase_size,
+                       uint16_t value_length_max,
+                       uint16_t key_capacity) : FlashWearLevellingUtils(start_addr,
+                                                                        memory_size,
+                                                                        page_erase_size,
+                                                                        KV_KEY_LENGTH + value_length_max),
+                                                _value_length_max(value_length_max),
+                                                _key_capacity(key_capacity),
+                                                _pIndex(nullptr),
+                                                _pScratch(nullptr),
+                                                _live_length(0),
+                                                _key_cnt(0)
+{
+    /* The index is built by the history */
+    _inPlace_isAllowed = false;
+} // FlashKeyValueStore
+
+FlashKeyValueStore::~FlashKeyValueStore()
+{
+    delete[] _pIndex;   /* free memory */
+    delete[] _pScratch; /* free memory */
+} // ~FlashKeyValueStore
+
+/**
+ * Find the last header and build the index of keys
+*/
+bool FlashKeyValueStore::begin(bool formatOnFail)
+{
+    if (!allocate())
+    {
+        FKV_TAG_INFO("[begin] Allocate RAM failed!");
+        return false;
+    }
+
+    if (!FlashWearLevellingUtils::begin(formatOnFail))
+    {
+        FKV_TAG_INFO("[begin] memory failed!");
+        return false;
+    }
+
+    /* Newest record first, the first record found of a key is the value */
+    indexClear();
+    if (!history(historyVisitor_t(this, &FlashKeyValueStore::indexRecord)))
+    {
+        FKV_TAG_INFO("[begin] history failed!");
+        return false;
+    }
+
+    FKV_TAG_INFO("[begin] key: %u, live length: %u", _key_cnt, _live_length);
+    return true;
+} // begin
+
+/**
+ * Format memory type as factory, all keys are removed
+*/
+bool FlashKeyValueStore::format()
+{
+    if (!FlashWearLevellingUtils::format())
+    {
+        return false;
+    }
+
+    headerDefault();
+    indexClear();
+    return true;
+} // format
+
+/** Write value of a key
+ *
+ *  @param key      The key id, 0xFFFF is reserved
+ *  @param buff     Buffer of data to write
+ *  @param length   Size to write in bytes
+ *  @return         True if write is succeed
+ */
+bool FlashKeyValueStore::set(uint16_t key, uint8_t *buff, uint32_t *length)
+{
+    kv_index_t *entry;
+    uint32_t live_length;
+
+    if ((KV_KEY_EMPTY == key) || (0 == *length) || (*length > _value_length_max) || (_pIndex == nullptr))
+    {
+        FKV_TAG_INFO("[set] key %u length %u failed!", key, *length);
+        return false;
+    }
+
+    entry = indexFind(key, true);
+    if (entry == nullptr)
+    {
+        FKV_TAG_INFO("[set] index is full!");
+        return false;
+    }
+
+    /* Live data must leave half of memory for compaction */
+    live_length = _live_length + _header2data_offset_length + KV_KEY_LENGTH + *length;
+    if (MEMORY_HEADER_END != entry->addr)
+    {
+        live_length -= recordLength(entry);
+    }
+    if (live_length > ((_memory_size - (_page_erase_size + 2 * (_header2data_offset_length + _data_length))) / 2))
+    {
+        FKV_TAG_INFO("[set] memory is not enough, live length %u", live_length);
+        return false;
+    }
+
+    if (!compact())
+    {
+        FKV_TAG_INFO("[set] compact failed!");
+        return false;
+    }
+
+    memcpy(_pScratch + _header2data_offset_length + KV_KEY_LENGTH, buff, *length);
+    if (!append(key, _pScratch + _header2data_offset_length + KV_KEY_LENGTH, *length))
+    {
+        FKV_TAG_INFO("[set] write failed!");
+        return false;
+    }
+
+    if (MEMORY_HEADER_END == entry->addr)
+    {
+        ++_key_cnt;
+    }
+    entry->addr = _memory_cxt.header.addr;
+    entry->length = *length;
+    _live_length = live_length;
+
+    return true;
+} // set
+
+/** Read value of a key
+ *
+ *  @param key      The key id
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if read is succeed
+ */
+bool FlashKeyValueStore::get(uint16_t key, uint8_t *buff, uint32_t *length)
+{
+    kv_index_t *entry;
+
+    if (_pIndex == nullptr)
+    {
+        return false;
+    }
+
+    entry = indexFind(key, false);
+    if ((entry == nullptr) || (MEMORY_HEADER_END == entry->addr))
+    {
+        FKV_TAG_INFO("[get] key %u not found!", key);
+        return false;
+    }
+
+    if ((*length) < entry->length)
+    {
+        FKV_TAG_INFO("[get] length buffer is not enough!");
+        return false;
+    }
+
+    if (!loadValue(entry))
+    {
+        FKV_TAG_INFO("[get] Data failed!");
+        return false;
+    }
+
+    memcpy(buff, _pScratch + _header2data_offset_length + KV_KEY_LENGTH, entry->length);
+    *length = entry->length;
+
+    return true;
+} // get
+
+/** Remove a key, a record with only key is written
+ *
+ *  @param key      The key id
+ *  @return         True if the key is removed
+ */
+bool FlashKeyValueStore::remove(uint16_t key)
+{
+    kv_index_t *entry;
+
+    if (!exists(key))
+    {
+        FKV_TAG_INFO("[remove] key %u not found!", key);
+        return false;
+    }
+
+    if (!compact())
+    {
+        FKV_TAG_INFO("[remove] compact failed!");
+        return false;
+    }
+
+    if (!append(key, nullptr, 0))
+    {
+        FKV_TAG_INFO("[remove] write failed!");
+        return false;
+    }
+
+    entry = indexFind(key, false);
+    _live_length -= recordLength(entry);
+    entry->addr = MEMORY_HEADER_END;
+    entry->length = 0;
+    --_key_cnt;
+
+    return true;
+} // remove
+
+/**
+ * The key have a value
+*/
+bool FlashKeyValueStore::exists(uint16_t key)
+{
+    kv_index_t *entry;
+
+    if (_pIndex == nullptr)
+    {
+        return false;
+    }
+
+    entry = indexFind(key, false);
+    return (entry != nullptr) && (MEMORY_HEADER_END != entry->addr);
+} // exists
+
+/**
+ * Return number of keys have a value
+*/
+uint16_t FlashKeyValueStore::count()
+{
+    return _key_cnt;
+} // count
+
+/**
+ * @brief Allocate the index and the scratch buffer a record.
+ */
+bool FlashKeyValueStore::allocate()
+{
+    /* Linear probing use the mask of capacity */
+    if ((0 == _key_capacity) || (_key_capacity & (_key_capacity - 1)))
+    {
+        FKV_TAG_INFO("[allocate] key capacity must be power of 2");
+        return false;
+    }
+
+    /* Compaction need a page erase and two records ahead */
+    if (_memory_size < 2U * ((uint32_t)_page_erase_size + 2U * ((uint32_t)_header2data_offset_length + _data_length)))
+    {
+        FKV_TAG_INFO("[allocate] memory size is not enough");
+        return false;
+    }
+
+    if (_pIndex == nullptr)
+    {
+        _pIndex = new (std::nothrow) kv_index_t[_key_capacity];
+    }
+
+    if (_pScratch == nullptr)
+    {
+        _pScratch = new (std::nothrow) uint8_t[_header2data_offset_length + _data_length];
+    }
+
+    return (_pIndex != nullptr) && (_pScratch != nullptr);
+} // allocate
+
+void FlashKeyValueStore::indexClear()
+{
+    for (uint16_t i = 0; i < _key_capacity; ++i)
+    {
+        _pIndex[i].key = KV_KEY_EMPTY;
+        _pIndex[i].length = 0;
+        _pIndex[i].addr = MEMORY_HEADER_END;
+    }
+    _live_length = 0;
+    _key_cnt = 0;
+} // indexClear
+
+/**
+ * @brief Find the entry of a key by linear probing.
+ * @param [in] key The key id.
+ * @param [in] insert Take an empty entry if the key is not found.
+ */
+FlashKeyValueStore::kv_index_t *FlashKeyValueStore::indexFind(uint16_t key, bool insert)
+{
+    uint16_t mask = _key_capacity - 1;
+    uint16_t idx = (uint16_t)(key * 40503U) & mask;
+
+    for (uint16_t i = 0; i < _key_capacity; ++i)
+    {
+        kv_index_t *entry = &_pIndex[(idx + i) & mask];
+
+        if (entry->key == key)
+        {
+            return entry;
+        }
+
+        if (KV_KEY_EMPTY == entry->key)
+        {
+            if (!insert)
+            {
+                return nullptr;
+            }
+            entry->key = key;
+            return entry;
+        }
+    }
+
+    return nullptr;
+} // indexFind
+
+/**
+ * @brief history visitor, add a key to the index at the first time.
+ * @param [in] memory_cxt_t The record, newest first.
+ */
+bool FlashKeyValueStore::indexRecord(const memory_cxt_t *mem)
+{
+    kv_index_t *entry;
+    uint16_t key;
+
+    if ((MEMORY_HEADER_TYPE != mem->header.type) || (mem->data.length < KV_KEY_LENGTH))
+    {
+        return true;
+    }
+
+    key = mem->data.pBuffer[0] | (mem->data.pBuffer[1] << 8);
+    if ((KV_KEY_EMPTY == key) || (indexFind(key, false) != nullptr))
+    {
+        return true;
+    }
+
+    entry = indexFind(key, true);
+    if (entry == nullptr)
+    {
+        FKV_TAG_INFO("[indexRecord] index is full!");
+        return false;
+    }
+
+    /* A record with only key is a removed key */
+    if (mem->data.length > KV_KEY_LENGTH)
+    {
+        entry->addr = mem->header.addr;
+        entry->length = mem->data.length - KV_KEY_LENGTH;
+        _live_length += recordLength(entry);
+        ++_key_cnt;
+    }
+
+    return true;
+} // indexRecord
+
+/**
+ * @brief Length of header and data of the newest record of a key.
+ */
+uint32_t FlashKeyValueStore::recordLength(kv_index_t *entry)
+{
+    return _header2data_offset_length + KV_KEY_LENGTH + entry->length;
+} // recordLength
+
+/**
+ * @brief Number of byte written before the page of the record is erased.
+ */
+uint32_t FlashKeyValueStore::killDistance(kv_index_t *entry)
+{
+    uint32_t page_addr;
+
+    page_addr = _start_addr + ((entry->addr - _start_addr) / _page_erase_size) * _page_erase_size;
+    return (page_addr + _memory_size - _memory_cxt.header.nextAddr) % _memory_size;
+} // killDistance
+
+/**
+ * @brief Check the pages erased by the next record overlap with the record of a key,
+ *        it is same rule with saveHeader() and eraseData().
+ * @param [in] length The length of header and data of the next record.
+ * @param [in] entry The key.
+ */
+bool FlashKeyValueStore::appendErases(uint32_t length, kv_index_t *entry)
+{
+    uint32_t end_addr, base_addr, erase_start, erase_end;
+
+    end_addr = _start_addr + _memory_size;
+    base_addr = _memory_cxt.header.nextAddr;
+    if ((base_addr + length) > end_addr)
+    {
+        /* Reset address, the first page is erased */
+        base_addr = _start_addr;
+        erase_start = _start_addr;
+    }
+    else
+    {
+        erase_start = _start_addr + ((base_addr - _start_addr) / _page_erase_size + 1) * _page_erase_size;
+    }
+
+    /* The page of the end of data is erased, even the data end at the begin of page */
+    erase_end = _start_addr + ((base_addr + length - _start_addr) / _page_erase_size + 1) * _page_erase_size;
+    if (erase_end > end_addr)
+    {
+        erase_end = end_addr;
+    }
+
+    if (erase_start >= erase_end)
+    {
+        return false;
+    }
+
+    return (entry->addr < erase_end) && ((entry->addr + recordLength(entry)) > erase_start);
+} // appendErases
+
+/**
+ * @brief Write a record of key, refuse to erase a page content the value of any key.
+ * @param [in] key The key id.
+ * @param [in] buff The value, must be at _pScratch + header + key.
+ * @param [in] length The length of value, 0 to remove the key.
+ */
+bool FlashKeyValueStore::append(uint16_t key, uint8_t *buff, uint16_t length)
+{
+    uint8_t *ptr_data = _pScratch + _header2data_offset_length;
+    uint32_t data_length = KV_KEY_LENGTH + length;
+
+    for (uint16_t i = 0; i < _key_capacity; ++i)
+    {
+        if ((KV_KEY_EMPTY != _pIndex[i].key) && (MEMORY_HEADER_END != _pIndex[i].addr)
+            && appendErases(_header2data_offset_length + data_length, &_pIndex[i]))
+        {
+            FKV_TAG_INFO("[append] the value of key %u is not moved!", _pIndex[i].key);
+            return false;
+        }
+    }
+
+    ptr_data[0] = key & 0xFF;
+    ptr_data[1] = key >> 8;
+    if ((length > 0) && (buff != (ptr_data + KV_KEY_LENGTH)))
+    {
+        memmove(ptr_data + KV_KEY_LENGTH, buff, length);
+    }
+
+    if (!write(ptr_data, &data_length))
+    {
+        return false;
+    }
+
+    return (data_length == (uint32_t)(KV_KEY_LENGTH + length));
+} // append
+
+/**
+ * @brief Read header and data of the newest record of a key by one onRead into _pScratch.
+ */
+bool FlashKeyValueStore::loadValue(kv_index_t *entry)
+{
+    memory_cxt_t mem_cxt;
+    uint32_t length;
+
+    length = recordLength(entry);
+    if (!_pCallbacks->onRead(entry->addr, _pScratch, &length))
+    {
+        FKV_TAG_INFO("[loadValue] Read failed!");
+        return false;
+    }
+
+    if (length != recordLength(entry))
+    {
+        FKV_TAG_INFO("[loadValue] Read length failed!");
+        return false;
+    }
+
+    mem_cxt.header.addr = entry->addr;
+    memcpy(&mem_cxt.header.crc32, _pScratch, _header2data_offset_length);
+    mem_cxt.data.addr = entry->addr + _header2data_offset_length;
+    mem_cxt.data.pBuffer = _pScratch + _header2data_offset_length;
+    mem_cxt.data.length = KV_KEY_LENGTH + entry->length;
+    if (!checkHeader(&mem_cxt) || (mem_cxt.header.dataLength != mem_cxt.data.length))
+    {
+        FKV_TAG_INFO("[loadValue] header failed!");
+        return false;
+    }
+
+    if (!verifyData(&mem_cxt))
+    {
+        return false;
+    }
+
+    return (entry->key == (mem_cxt.data.pBuffer[0] | (mem_cxt.data.pBuffer[1] << 8)));
+} // loadValue
+
+/**
+ * @brief Copy forward the values in the pages will be erased soon,
+ *        the nearest first.
+ */
+bool FlashKeyValueStore::compact()
+{
+    kv_index_t *entry;
+    uint32_t threshold, distance, min_distance;
+
+    /* The next record and the moved records can not reach a live page */
+    threshold = _page_erase_size + 2 * (_header2data_offset_length + _data_length);
+    for (uint16_t moved = 0; moved < _key_capacity; ++moved)
+    {
+        entry = nullptr;
+        min_distance = threshold;
+        for (uint16_t i = 0; i < _key_capacity; ++i)
+        {
+            if ((KV_KEY_EMPTY == _pIndex[i].key) || (MEMORY_HEADER_END == _pIndex[i].addr))
+            {
+                continue;
+            }
+
+            distance = killDistance(&_pIndex[i]);
+            if (distance < min_distance)
+            {
+                min_distance = distance;
+                entry = &_pIndex[i];
+            }
+        }
+
+        if (entry == nullptr)
+        {
+            return true;
+        }
+
+        FKV_TAG_INFO("[compact] move key %u at %u(0x%X)", entry->key, entry->addr, entry->addr);
+        if (!loadValue(entry)
+            || !append(entry->key, _pScratch + _header2data_offset_length + KV_KEY_LENGTH, entry->length))
+        {
+            FKV_TAG_INFO("[compact] move key %u failed!", entry->key);
+            return false;
+        }
+        entry->addr = _memory_cxt.header.addr;
+    }
+
+    return true;
+} // compact
@@ -0,0 +1,118 @@
+/** @file FlashKeyValueStore.h
+ *  @brief utility support saving many small variables with a key id
+ *         into one wear levelling memory region
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_KEY_VALUE_STORE_H
+#define __FLASH_KEY_VALUE_STORE_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define KV_VALUE_LENGTH_DEFAULT 32U /* 32-Byte */
+#define KV_KEY_CAPACITY_DEFAULT 64U /* must be power of 2 */
+
+#define FKV_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FKV]", __VA_ARGS__)
+
+/**
+ * The record data of key value store: key (2-byte) + value.
+ * A record with only key is a removed key.
+ */
+class FlashKeyValueStore : protected FlashWearLevellingUtils
+{
+    typedef enum
+    {
+        KV_KEY_EMPTY = 0xFFFF,
+        KV_KEY_LENGTH = 2
+    } kvType_t;
+
+    typedef struct
+    {
+        uint16_t key;
+        uint16_t length; /* value length */
+        uint32_t addr;   /* header address of the newest record, MEMORY_HEADER_END if removed */
+    } kv_index_t;
+
+public:
+    FlashKeyValueStore(uint32_t start_addr = 0,
+                       size_t memory_size = MEMORY_SIZE_DEFAULT,
+                       uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT,
+                       uint16_t value_length_max = KV_VALUE_LENGTH_DEFAULT,
+                       uint16_t key_capacity = KV_KEY_CAPACITY_DEFAULT);
+    ~FlashKeyValueStore();
+
+    using FlashWearLevellingUtils::setCallbacks;
+    using FlashWearLevellingUtils::stats;
+    using FlashWearLevellingUtils::resetStats;
+    using FlashWearLevellingUtils::writeAmplification;
+    using FlashWearLevellingUtils::lifetime;
+    using FlashWearLevellingUtils::info;
+    bool begin(bool formatOnFail = false);
+    bool format();
+    bool set(uint16_t key, uint8_t *buff, uint32_t *length);
+    bool get(uint16_t key, uint8_t *buff, uint32_t *length);
+    bool remove(uint16_t key);
+    bool exists(uint16_t key);
+    uint16_t count();
+
+    template <typename varType>
+    bool set(uint16_t key, varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        if (set(key, (uint8_t *)data, &length))
+        {
+            if (length == sizeof(varType))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    } // set
+
+    template <typename varType>
+    bool get(uint16_t key, varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        if (get(key, (uint8_t *)data, &length))
+        {
+            if (length == sizeof(varType))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    } // get
+
+private:
+    const uint16_t _value_length_max;
+    const uint16_t _key_capacity;
+    kv_index_t *_pIndex;
+    uint8_t *_pScratch;
+    uint32_t _live_length;
+    uint16_t _key_cnt;
+    bool allocate();
+    void indexClear();
+    kv_index_t *indexFind(uint16_t key, bool insert);
+    bool indexRecord(const memory_cxt_t *mem);
+    uint32_t recordLength(kv_index_t *entry);
+    uint32_t killDistance(kv_index_t *entry);
+    bool appendErases(uint32_t length, kv_index_t *entry);
+    bool append(uint16_t key, uint8_t *buff, uint16_t length);
+    bool loadValue(kv_index_t *entry);
+    bool compact();
+};
+
+#endif
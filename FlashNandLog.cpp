@@ -0,0 +1,649 @@
+#include "FlashNandLog.h"
+#include "util_crc32.h"
+#include "util_ecc.h"
+
+FlashNandLog::
+    FlashNandLog(uint32_t start_addr,
+                 size_t memory_size,
+                 uint32_t block_size,
+                 uint16_t page_size,
+                 uint16_t oob_size) : _start_addr(start_addr),
+                                      _memory_size(memory_size),
+                                      _block_size(block_size),
+                                      _page_size(page_size),
+                                      _oob_size(oob_size),
+                                      _pPage(nullptr),
+                                      _pRead(nullptr),
+                                      _pOob(nullptr),
+                                      _ecc_length(ECC_LENGTH(page_size)),
+                                      _ecc_isEnable(false),
+                                      _ecc_corrected(0),
+                                      _page_used(0),
+                                      _last_addr(NAND_PAGE_END),
+                                      _next_addr(start_addr),
+                                      _sequence(0)
+{
+    _pCallbacks = &defaultCallback;
+} // FlashNandLog
+
+FlashNandLog::~FlashNandLog()
+{
+    delete[] _pPage; /* free memory */
+    delete[] _pRead; /* free memory */
+    delete[] _pOob;  /* free memory */
+} // ~FlashNandLog
+
+/**
+ * @brief Set the callback handlers for this flash memory.
+ * @param [in] pCallbacks An instance of a callbacks structure used to define any callbacks for the flash memory.
+ */
+void FlashNandLog::setCallbacks(FlashWearLevellingCallbacks *pCallbacks)
+{
+    if (pCallbacks != nullptr)
+    {
+        _pCallbacks = pCallbacks;
+    }
+    else
+    {
+        _pCallbacks = &defaultCallback;
+    }
+} // setCallbacks
+
+/**
+ * Find the newest block by the spare area of its first page, then binary search its last page.
+ * The metadata of a first page is broken, the next pages of block tell its sequence
+*/
+bool FlashNandLog::begin(bool formatOnFail)
+{
+    nand_oob_t oob;
+    uint32_t block, block_addr, page, lo, hi, mid;
+    bool blank, valid;
+
+    if (!verifyMemInfo())
+    {
+        FNL_TAG_INFO("[begin] memory info Failed!");
+        return false;
+    }
+
+    if (_pPage == nullptr)
+    {
+        _pPage = new (std::nothrow) uint8_t[_page_size];
+    }
+    if (_pRead == nullptr)
+    {
+        _pRead = new (std::nothrow) uint8_t[_page_size];
+    }
+    if (_pOob == nullptr)
+    {
+        _pOob = new (std::nothrow) uint8_t[_oob_size];
+    }
+    if ((_pPage == nullptr) || (_pRead == nullptr) || (_pOob == nullptr))
+    {
+        FNL_TAG_INFO("[begin] Allocate RAM failed!");
+        return false;
+    }
+
+    _page_used = 0;
+    block_addr = NAND_PAGE_END;
+    for (block = _start_addr; block < (_start_addr + _memory_size); block += _block_size)
+    {
+        if (blockBad(block) || !readOob(block, &oob, &blank) || blank)
+        {
+            continue;
+        }
+
+        /* A block not blank is never taken as free before its pages are checked */
+        valid = (oobCrc32(&oob) == oob.crc32);
+        for (page = 1; !valid && (page < (_block_size / _page_size)); ++page)
+        {
+            if (!readOob(block + page * _page_size, &oob, &blank) || blank)
+            {
+                break;
+            }
+            valid = (oobCrc32(&oob) == oob.crc32);
+        }
+
+        if (valid && ((NAND_PAGE_END == block_addr) || ((int32_t)(oob.sequence - _sequence) > 0)))
+        {
+            block_addr = block;
+            _sequence = oob.sequence;
+        }
+    }
+
+    if (NAND_PAGE_END == block_addr)
+    {
+        FNL_TAG_INFO("[begin] Not Found page");
+        _last_addr = NAND_PAGE_END;
+        _next_addr = _start_addr;
+        _sequence = 0;
+        return formatOnFail ? format() : false;
+    }
+
+    /* The pages of a block are programmed in order, binary search the last page is not blank */
+    lo = 0;
+    hi = (_block_size / _page_size) - 1;
+    while (lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        if (!readOob(block_addr + mid * _page_size, &oob, &blank))
+        {
+            return false;
+        }
+
+        if (blank)
+        {
+            hi = mid - 1;
+        }
+        else
+        {
+            lo = mid;
+        }
+    }
+
+    _next_addr = block_addr + (lo + 1) * _page_size;
+    if (_next_addr == (block_addr + _block_size))
+    {
+        _next_addr = nextBlock(block_addr);
+    }
+
+    /* The newest valid page, the last page can be broken by a power lost */
+    do
+    {
+        if (readOob(block_addr + lo * _page_size, &oob, &blank) && !blank && (oobCrc32(&oob) == oob.crc32))
+        {
+            _last_addr = block_addr + lo * _page_size;
+            _sequence = oob.sequence;
+            break;
+        }
+    } while (lo-- > 0);
+
+    FNL_TAG_INFO("[begin] last %u(0x%X) next %u(0x%X) sequence %u", _last_addr, _last_addr, _next_addr, _next_addr, _sequence);
+    return true;
+} // begin
+
+/**
+ * Format memory type as factory, all good blocks are erased
+*/
+bool FlashNandLog::format()
+{
+    uint32_t block;
+
+    for (block = _start_addr; block < (_start_addr + _memory_size); block += _block_size)
+    {
+        if (blockBad(block))
+        {
+            continue;
+        }
+
+        if (!_pCallbacks->onErase(block, _block_size))
+        {
+            FNL_TAG_INFO("[format] erase failed!");
+            markBad(block);
+        }
+    }
+
+    _page_used = 0;
+    _last_addr = NAND_PAGE_END;
+    _next_addr = nextBlock(_start_addr + _memory_size - _block_size);
+    _sequence = 0;
+    return true;
+} // format
+
+/** Buffer a record, the page is programmed when the record does not fit
+ *
+ *  @param buff     Buffer of data to write
+ *  @param length   Size to write in bytes, (page size - 2) at most
+ *  @return         True if write is succeed
+ */
+bool FlashNandLog::append(uint8_t *buff, uint32_t length)
+{
+    uint16_t prefix = length;
+
+    if ((_pPage == nullptr) || (length > (uint32_t)(_page_size - NAND_RECORD_PREFIX_LENGTH)))
+    {
+        FNL_TAG_INFO("[append] length failed!");
+        return false;
+    }
+
+    if (((uint32_t)_page_used + NAND_RECORD_PREFIX_LENGTH + length) > _page_size)
+    {
+        if (!flush())
+        {
+            return false;
+        }
+    }
+
+    memcpy(_pPage + _page_used, &prefix, NAND_RECORD_PREFIX_LENGTH);
+    if (length > 0)
+    {
+        memcpy(_pPage + _page_used + NAND_RECORD_PREFIX_LENGTH, buff, length);
+    }
+    _page_used += NAND_RECORD_PREFIX_LENGTH + length;
+    return true;
+} // append
+
+/**
+ * Program the records buffered
+*/
+bool FlashNandLog::flush()
+{
+    if (0 == _page_used)
+    {
+        return true;
+    }
+
+    return programPage();
+} // flush
+
+uint32_t FlashNandLog::buffered()
+{
+    return _page_used;
+} // buffered
+
+/** Read the newest record, buffered or programmed
+ *
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if read is succeed
+ */
+bool FlashNandLog::read(uint8_t *buff, uint32_t *length)
+{
+    nand_oob_t oob;
+    uint8_t *page = _pPage;
+    uint32_t offset, last = NAND_PAGE_END, used = _page_used;
+    uint16_t prefix;
+
+    if (0 == used)
+    {
+        if ((NAND_PAGE_END == _last_addr) || !readPage(_last_addr, &oob))
+        {
+            FNL_TAG_INFO("[read] no data!");
+            return false;
+        }
+        page = _pRead;
+        used = oob.used;
+    }
+
+    for (offset = 0; (offset + NAND_RECORD_PREFIX_LENGTH) <= used; offset += NAND_RECORD_PREFIX_LENGTH + prefix)
+    {
+        memcpy(&prefix, page + offset, NAND_RECORD_PREFIX_LENGTH);
+        last = offset;
+    }
+
+    if (NAND_PAGE_END == last)
+    {
+        return false;
+    }
+
+    memcpy(&prefix, page + last, NAND_RECORD_PREFIX_LENGTH);
+    if (*length < prefix)
+    {
+        FNL_TAG_INFO("[read] length buffer is not enough!");
+        return false;
+    }
+
+    memcpy(buff, page + last + NAND_RECORD_PREFIX_LENGTH, prefix);
+    *length = prefix;
+    return true;
+} // read
+
+/**
+ * Enable the code of pages programmed, the pages are read by the flags of their metadata.
+ * False if the spare area is not enough for the metadata and the code.
+*/
+bool FlashNandLog::setEcc(bool enable)
+{
+    if (enable && (_oob_size < (NAND_OOB_LENGTH + _ecc_length)))
+    {
+        FNL_TAG_INFO("[setEcc] spare size %u, min = %u", _oob_size, NAND_OOB_LENGTH + _ecc_length);
+        return false;
+    }
+
+    _ecc_isEnable = enable;
+    return true;
+} // setEcc
+
+/**
+ * Return the number of pages corrected by the code
+*/
+uint32_t FlashNandLog::eccCorrected()
+{
+    return _ecc_corrected;
+} // eccCorrected
+
+/**
+ * @brief Walk the records, the buffered records first, then the pages from the newest.
+ *        The records of a page are visited from the last one.
+ * @param [in] visitor Return false to stop.
+ * @param [in] pageCount The number of pages programmed are read.
+ */
+bool FlashNandLog::records(recordVisitor_t visitor, uint32_t pageCount)
+{
+    nand_oob_t oob;
+    uint8_t *page = _pPage;
+    uint32_t addr, used = _page_used, step, offset, count, i, k;
+    uint32_t sequence = _sequence + 1U;
+    uint16_t prefix;
+    bool blank;
+
+    addr = _last_addr;
+    for (step = 0; step <= (_memory_size / _page_size); ++step)
+    {
+        if (step > 0)
+        {
+            if ((NAND_PAGE_END == addr) || (0 == pageCount))
+            {
+                break;
+            }
+
+            if (!readOob(addr, &oob, &blank))
+            {
+                return false;
+            }
+
+            /* A blank or broken page is skipped, an older sequence is the end */
+            if (blank || (oobCrc32(&oob) != oob.crc32))
+            {
+                addr = prevPage(addr);
+                continue;
+            }
+            if ((int32_t)(sequence - oob.sequence) <= 0)
+            {
+                break;
+            }
+            sequence = oob.sequence;
+
+            if (!readPage(addr, &oob))
+            {
+                FNL_TAG_INFO("[records] page %u(0x%X) failed!", addr, addr);
+                addr = prevPage(addr);
+                continue;
+            }
+            --pageCount;
+            page = _pRead;
+            used = oob.used;
+            addr = prevPage(addr);
+        }
+
+        /* The records are stored in order, count them and visit from the last */
+        count = 0;
+        for (offset = 0; (offset + NAND_RECORD_PREFIX_LENGTH) <= used; offset += NAND_RECORD_PREFIX_LENGTH + prefix)
+        {
+            memcpy(&prefix, page + offset, NAND_RECORD_PREFIX_LENGTH);
+            ++count;
+        }
+
+        for (i = count; i > 0; --i)
+        {
+            offset = 0;
+            for (k = 1; k < i; ++k)
+            {
+                memcpy(&prefix, page + offset, NAND_RECORD_PREFIX_LENGTH);
+                offset += NAND_RECORD_PREFIX_LENGTH + prefix;
+            }
+
+            memcpy(&prefix, page + offset, NAND_RECORD_PREFIX_LENGTH);
+            if (!visitor(page + offset + NAND_RECORD_PREFIX_LENGTH, prefix))
+            {
+                return true;
+            }
+        }
+    }
+
+    return true;
+} // records
+
+/**
+ * verify memory information
+*/
+bool FlashNandLog::verifyMemInfo()
+{
+    if ((0 == _page_size) || (_oob_size < NAND_OOB_LENGTH)
+        || (_ecc_isEnable && (_oob_size < (NAND_OOB_LENGTH + _ecc_length))))
+    {
+        FNL_TAG_INFO("[verifyMemInfo][error] page size or spare size failed!");
+        return false;
+    }
+
+    if ((0 == _block_size) || (_block_size % _page_size) || (_start_addr % _block_size))
+    {
+        FNL_TAG_INFO("[verifyMemInfo][error] _block_size must be multiples _page_size");
+        return false;
+    }
+
+    /* The newest block is never erased before the next block is programmed */
+    if ((_memory_size % _block_size) || ((_memory_size / _block_size) < 2))
+    {
+        FNL_TAG_INFO("[verifyMemInfo][error] _memory_size must be 2 blocks at least");
+        return false;
+    }
+
+    return true;
+} // verifyMemInfo
+
+/**
+ * @brief Read only the spare area of a page.
+ * @param [out] blank The metadata of page is blank.
+ */
+bool FlashNandLog::readOob(uint32_t addr, nand_oob_t *oob, bool *blank)
+{
+    if (!_pCallbacks->onPageRead(addr, nullptr, 0, (uint8_t *)oob, NAND_OOB_LENGTH))
+    {
+        FNL_TAG_INFO("[readOob] Read failed!");
+        return false;
+    }
+
+    *blank = true;
+    for (uint8_t i = 0; i < NAND_OOB_LENGTH; ++i)
+    {
+        if (0xFF != ((uint8_t *)oob)[i])
+        {
+            *blank = false;
+            break;
+        }
+    }
+
+    return true;
+} // readOob
+
+/**
+ * @brief Read a page into _pRead and verify its spare area and data.
+ */
+bool FlashNandLog::readPage(uint32_t addr, nand_oob_t *oob)
+{
+    uint32_t oob_length = NAND_OOB_LENGTH;
+
+    if (_oob_size >= (NAND_OOB_LENGTH + _ecc_length))
+    {
+        oob_length += _ecc_length;
+    }
+
+    if (!_pCallbacks->onPageRead(addr, _pRead, _page_size, _pOob, oob_length))
+    {
+        FNL_TAG_INFO("[readPage] Read failed!");
+        return false;
+    }
+
+    memcpy(oob, _pOob, NAND_OOB_LENGTH);
+    if ((oobCrc32(oob) != oob->crc32) || (oob->used > _page_size))
+    {
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_HEADER);
+        return false;
+    }
+
+    if ((Crc32_CalculateBuffer(_pRead, oob->used) != oob->dataCrc32) && !correctPage(oob))
+    {
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_DATA);
+        return false;
+    }
+
+    return true;
+} // readPage
+
+/**
+ * @brief Correct the data of _pRead by the code read in _pOob, the CRC32 is verified again.
+ */
+bool FlashNandLog::correctPage(nand_oob_t *oob)
+{
+    ecc_result_t result;
+
+    if ((oob->flags & NAND_FLAG_NO_ECC) || (_oob_size < (NAND_OOB_LENGTH + _ecc_length)))
+    {
+        return false;
+    }
+
+    result = ECC_Correct(_pRead, _page_size, _pOob + NAND_OOB_LENGTH);
+    if ((ECC_UNCORRECTABLE == result) || (Crc32_CalculateBuffer(_pRead, oob->used) != oob->dataCrc32))
+    {
+        FNL_TAG_INFO("[correctPage] uncorrectable!");
+        return false;
+    }
+
+    FNL_TAG_INFO("[correctPage] corrected");
+    ++_ecc_corrected;
+    return true;
+} // correctPage
+
+/**
+ * @brief Program the records buffered to the next page, a block is erased at its first page.
+ *        The page is programmed to the next block if the erase or the program failed, the block
+ *        is marked bad if its first page failed.
+ */
+bool FlashNandLog::programPage()
+{
+    nand_oob_t oob;
+    uint32_t addr = _next_addr, block_addr;
+
+    memset(_pPage + _page_used, 0xFF, _page_size - _page_used);
+    memset(&oob, 0xFF, sizeof(nand_oob_t));
+    oob.marker = NAND_MARKER_GOOD;
+    oob.flags = _ecc_isEnable ? (uint8_t)~NAND_FLAG_NO_ECC : 0xFF;
+    oob.used = _page_used;
+    oob.sequence = _sequence + 1U;
+    oob.dataCrc32 = Crc32_CalculateBuffer(_pPage, _page_used);
+    oob.crc32 = oobCrc32(&oob);
+    memcpy(_pOob, &oob, NAND_OOB_LENGTH);
+    if (_ecc_isEnable)
+    {
+        ECC_Calculate(_pPage, _page_size, _pOob + NAND_OOB_LENGTH);
+    }
+
+    for (uint32_t i = 0; i <= (_memory_size / _block_size); ++i)
+    {
+        block_addr = addr - ((addr - _start_addr) % _block_size);
+        if (addr == block_addr)
+        {
+            FNL_TAG_INFO("[programPage] erase block %u(0x%X)", block_addr, block_addr);
+            if (!_pCallbacks->onErase(block_addr, _block_size))
+            {
+                FNL_TAG_INFO("[programPage] erase failed!");
+                markBad(block_addr);
+                addr = nextBlock(block_addr);
+                continue;
+            }
+        }
+
+        if (!_pCallbacks->onPageProgram(addr, _pPage, _page_size, _pOob,
+                                        NAND_OOB_LENGTH + (_ecc_isEnable ? _ecc_length : 0)))
+        {
+            /* The pages programmed of this block are still read, the block is erased again at next round */
+            FNL_TAG_INFO("[programPage] program failed!");
+            _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+            if (addr == block_addr)
+            {
+                markBad(block_addr);
+            }
+            addr = nextBlock(block_addr);
+            continue;
+        }
+
+        _last_addr = addr;
+        _sequence = oob.sequence;
+        _page_used = 0;
+        _next_addr = addr + _page_size;
+        if (_next_addr == (block_addr + _block_size))
+        {
+            _next_addr = nextBlock(block_addr);
+        }
+        return true;
+    }
+
+    FNL_TAG_INFO("[programPage] no good block!");
+    return false;
+} // programPage
+
+/**
+ * @brief The block is bad by the factory marker or the marker of its first page.
+ */
+bool FlashNandLog::blockBad(uint32_t block_addr)
+{
+    nand_oob_t oob;
+    bool blank;
+
+    if (_pCallbacks->onBadBlock(block_addr))
+    {
+        return true;
+    }
+
+    return readOob(block_addr, &oob, &blank) && (NAND_MARKER_GOOD != oob.marker);
+} // blockBad
+
+/**
+ * @brief Program the bad marker to the spare area of the first page, at best.
+ */
+void FlashNandLog::markBad(uint32_t block_addr)
+{
+    uint8_t marker = NAND_MARKER_BAD;
+
+    FNL_TAG_INFO("[markBad] block %u(0x%X)", block_addr, block_addr);
+    _pCallbacks->onPageProgram(block_addr, nullptr, 0, &marker, 1);
+} // markBad
+
+/**
+ * @brief The next good block, wrap to the start.
+ */
+uint32_t FlashNandLog::nextBlock(uint32_t block_addr)
+{
+    for (uint32_t i = 0; i < (_memory_size / _block_size); ++i)
+    {
+        block_addr += _block_size;
+        if (block_addr >= (_start_addr + _memory_size))
+        {
+            block_addr = _start_addr;
+        }
+
+        if (!blockBad(block_addr))
+        {
+            break;
+        }
+    }
+
+    return block_addr;
+} // nextBlock
+
+/**
+ * @brief The previous page, the bad blocks are skipped and wrap to the end.
+ */
+uint32_t FlashNandLog::prevPage(uint32_t addr)
+{
+    if ((addr - _start_addr) % _block_size)
+    {
+        return addr - _page_size;
+    }
+
+    for (uint32_t i = 0; i < (_memory_size / _block_size); ++i)
+    {
+        addr = (addr == _start_addr) ? (_start_addr + _memory_size - _block_size) : (addr - _block_size);
+        if (!blockBad(addr))
+        {
+            break;
+        }
+    }
+
+    return addr + _block_size - _page_size;
+} // prevPage
+
+uint32_t FlashNandLog::oobCrc32(nand_oob_t *oob)
+{
+    return Crc32_CalculateBuffer((uint8_t *)oob, NAND_OOB_LENGTH - sizeof(uint32_t));
+} // oobCrc32
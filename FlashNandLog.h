@@ -0,0 +1,128 @@
+/** @file FlashNandLog.h
+ *  @brief utility support logging records into a space NAND memory, each page
+ *         is programmed once with its metadata in the spare area (OOB)
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_NAND_LOG_H
+#define __FLASH_NAND_LOG_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define FNL_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FNL]", __VA_ARGS__)
+
+/**
+ * The records are buffered in RAM and a whole page is programmed by one onPageProgram(),
+ * the page data is (length (2-byte) + data) of each record. The spare area of a page have
+ * the bad block marker, the sequence of page, the used length and the CRC32 of data.
+ * The pages are programmed in order, a block is erased when its first page is programmed.
+ * Mount read the spare area of the first page of each block and binary search the last
+ * page of the newest block, the next pages of a block are read if the first one is broken. The records buffered are lost by a power lost, call flush().
+ *
+ * A block is bad if onBadBlock() report it or the marker of its first page is not 0xFF,
+ * an erase or a program of its first page failed mark the block bad. A program failed at a later
+ * page keep the block, the pages programmed are still read and the block is erased again at next round.
+ * The page failed is programmed to the next block.
+ *
+ * Optional ECC (setEcc): a Hamming code of each 256-byte of page follow the metadata in the spare
+ * area, the spare area must have 16 + 3 * (page size / 256) bytes. The code is used only if the
+ * CRC32 of data failed, a single bit error of each 256-byte is corrected.
+ */
+class FlashNandLog
+{
+    typedef enum
+    {
+        NAND_OOB_LENGTH = 16,
+        NAND_RECORD_PREFIX_LENGTH = 2,
+        NAND_MARKER_GOOD = 0xFF,
+        NAND_MARKER_BAD = 0x00,
+        NAND_FLAG_NO_ECC = 0x01, /* cleared if the code follow the metadata */
+        NAND_PAGE_END = 0xFFFFFFFF
+    } nandType_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint8_t marker; /* bad block marker, the first byte of spare area */
+        uint8_t flags;
+        uint16_t used; /* the length of page data */
+        uint32_t sequence;
+        uint32_t dataCrc32;
+        uint32_t crc32; /* marker, flags, used, sequence and data CRC32 */
+    } nand_oob_t;
+
+public:
+    FlashNandLog(uint32_t start_addr = 0,
+                 size_t memory_size = 131072U,
+                 uint32_t block_size = 131072U,
+                 uint16_t page_size = 2048,
+                 uint16_t oob_size = 64);
+    ~FlashNandLog();
+    void setCallbacks(FlashWearLevellingCallbacks *pCallbacks);
+    bool begin(bool formatOnFail = false);
+    bool format();
+    bool append(uint8_t *buff, uint32_t length);
+    bool flush();
+    uint32_t buffered();
+    bool read(uint8_t *buff, uint32_t *length);
+    /* False if the spare area have not 16 + 3 * (page size / 256) bytes */
+    bool setEcc(bool enable);
+    uint32_t eccCorrected();
+
+    /* Visitor return false to stop walking, the newest record first */
+    typedef mbed::Callback<bool(const uint8_t *, uint32_t)> recordVisitor_t;
+    bool records(recordVisitor_t visitor, uint32_t pageCount = UINT32_MAX);
+
+    template <typename varType>
+    bool append(varType *data)
+    {
+        return append((uint8_t *)data, sizeof(varType));
+    } // append
+
+    template <typename varType>
+    bool read(varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        return read((uint8_t *)data, &length) && (length == sizeof(varType));
+    } // read
+
+private:
+    const uint32_t _start_addr;
+    const size_t _memory_size;
+    const uint32_t _block_size;
+    const uint16_t _page_size;
+    const uint16_t _oob_size;
+    uint8_t *_pPage;        /* records buffered */
+    uint8_t *_pRead;        /* page read */
+    uint8_t *_pOob;         /* metadata + code */
+    const uint16_t _ecc_length;
+    bool _ecc_isEnable;
+    uint32_t _ecc_corrected;
+    uint16_t _page_used;
+    uint32_t _last_addr;    /* the newest page programmed, NAND_PAGE_END if no page */
+    uint32_t _next_addr;
+    uint32_t _sequence;
+    FlashWearLevellingCallbacks *_pCallbacks;
+    bool verifyMemInfo();
+    bool readOob(uint32_t addr, nand_oob_t *oob, bool *blank);
+    bool readPage(uint32_t addr, nand_oob_t *oob);
+    bool correctPage(nand_oob_t *oob);
+    bool programPage();
+    bool blockBad(uint32_t block_addr);
+    void markBad(uint32_t block_addr);
+    uint32_t nextBlock(uint32_t block_addr);
+    uint32_t prevPage(uint32_t addr);
+    uint32_t oobCrc32(nand_oob_t *oob);
+};
+
+#endif
@@ -0,0 +1,786 @@
+#include "FlashPartitionManager.h"
+#include "util_crc32.h"
+
+FlashPartitionManager::
+    FlashPartitionManager(uint32_t start_addr,
+                          size_t device_size,
+                          uint16_t page_erase_size,
+                          bool wear_levelling) : _start_addr(start_addr),
+                                                 _device_size(device_size),
+                                                 _page_erase_size(page_erase_size),
+                                                 _wear_levelling(wear_levelling),
+                                                 _page_size(wear_levelling ? (page_erase_size - PAGE_HEADER_LENGTH) : page_erase_size),
+                                                 _pPartition(nullptr),
+                                                 _partition_cnt(0),
+                                                 _used_size(0),
+                                                 _pScratch(nullptr),
+                                                 _pCopy(nullptr),
+                                                 _physical_cnt(0),
+                                                 _logical_cnt(0),
+                                                 _pMap(nullptr),
+                                                 _pOwner(nullptr),
+                                                 _pEraseCount(nullptr),
+                                                 _sequence(0),
+                                                 _static_threshold(0),
+                                                 _static_interval(0),
+                                                 _erase_since_static(0)
+{
+    _pCallbacks = &defaultCallback;
+} // FlashPartitionManager
+
+FlashPartitionManager::~FlashPartitionManager()
+{
+    /* Another manager can share its scratch after mount() */
+    FlashWearLevellingUtils::releaseScratch(_pScratch);
+    delete[] _pScratch;    /* free memory */
+    delete[] _pCopy;       /* free memory */
+    delete[] _pPartition;  /* free memory */
+    delete[] _pMap;        /* free memory */
+    delete[] _pOwner;      /* free memory */
+    delete[] _pEraseCount; /* free memory */
+} // ~FlashPartitionManager
+
+/**
+ * @brief Set the callbacks of flash device.
+ * @param [in] pCallbacks An instance of a callbacks structure used to access the device.
+ */
+void FlashPartitionManager::setCallbacks(FlashWearLevellingCallbacks *pCallbacks)
+{
+    if (pCallbacks != nullptr)
+    {
+        _pCallbacks = pCallbacks;
+    }
+    else
+    {
+        _pCallbacks = &defaultCallback;
+    }
+} // setCallbacks
+
+/** Carve the partitions from the device in table order
+ *
+ *  @param table    The partitions, the table must be available while the manager is used
+ *  @param count    The number of partitions
+ *  @return         True if all partitions fit the device
+ */
+bool FlashPartitionManager::setTable(const partition_t *table, uint8_t count)
+{
+    uint32_t addr;
+
+    if ((_page_erase_size <= PAGE_HEADER_LENGTH) || (_start_addr % _page_erase_size) || (_device_size % _page_erase_size)
+        || ((_device_size / _page_erase_size) >= PARTITION_PAGE_BAD))
+    {
+        FPM_TAG_INFO("[setTable] device must be multiples page erase size");
+        return false;
+    }
+
+    addr = _start_addr;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        if ((0 == table[i].size) || (table[i].size % _page_erase_size)
+            || (table[i].size > ((_start_addr + _device_size) - addr)))
+        {
+            FPM_TAG_INFO("[setTable] partition %u size failed!", i);
+            return false;
+        }
+        addr += table[i].size;
+    }
+
+    /* A logical page is moved to a free page when it is erased */
+    if (_wear_levelling && ((addr - _start_addr) >= _device_size))
+    {
+        FPM_TAG_INFO("[setTable] no spare page for wear levelling");
+        return false;
+    }
+
+    delete[] _pPartition;  /* free memory */
+    delete[] _pMap;        /* free memory */
+    delete[] _pOwner;      /* free memory */
+    delete[] _pEraseCount; /* free memory */
+    _pMap = nullptr;
+    _pOwner = nullptr;
+    _pEraseCount = nullptr;
+    _partition_cnt = 0;
+    _used_size = addr - _start_addr;
+    _physical_cnt = _device_size / _page_erase_size;
+    _logical_cnt = _used_size / _page_erase_size;
+
+    _pPartition = new (std::nothrow) partition_cxt_t[count];
+    if (_wear_levelling)
+    {
+        _pMap = new (std::nothrow) uint16_t[_logical_cnt];
+        _pOwner = new (std::nothrow) uint16_t[_physical_cnt];
+        _pEraseCount = new (std::nothrow) uint32_t[_physical_cnt];
+    }
+    if ((_pPartition == nullptr) || (_wear_levelling && ((_pMap == nullptr) || (_pOwner == nullptr) || (_pEraseCount == nullptr))))
+    {
+        FPM_TAG_INFO("[setTable] Allocate RAM failed!");
+        return false;
+    }
+
+    /* The address of regions, logical address from 0 in wear levelling mode */
+    addr = _wear_levelling ? 0 : _start_addr;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        _pPartition[i].start = addr;
+        _pPartition[i].size = (table[i].size / _page_erase_size) * _page_size;
+        _pPartition[i].name = table[i].name;
+        _pPartition[i].pRegion = nullptr;
+        _pPartition[i].mount = nullptr;
+        FPM_TAG_INFO("[setTable] %s: %u(0x%X) size %u", table[i].name, addr, addr, _pPartition[i].size);
+        addr += _pPartition[i].size;
+    }
+
+    _partition_cnt = count;
+    return true;
+} // setTable
+
+/** Mount all regions attached in one pass from the lowest address,
+ *  the regions share one scratch buffer
+ *
+ *  @param formatOnFail Format a region can not be mounted
+ *  @return             True if all regions are mounted
+ */
+bool FlashPartitionManager::mount(bool formatOnFail)
+{
+    bool status_isOK = true;
+
+    if (_pScratch == nullptr)
+    {
+        _pScratch = new (std::nothrow) uint8_t[HISTORY_PREFETCH_SIZE_DEFAULT];
+        if (_pScratch != nullptr)
+        {
+            FlashWearLevellingUtils::setScratch(_pScratch, HISTORY_PREFETCH_SIZE_DEFAULT);
+        }
+    }
+
+    /* The data of a region can be in the shared scratch when its page is relocated */
+    if (_wear_levelling && (_pCopy == nullptr))
+    {
+        _pCopy = new (std::nothrow) uint8_t[HISTORY_PREFETCH_SIZE_DEFAULT];
+    }
+
+    if (_wear_levelling && !mountPages())
+    {
+        FPM_TAG_INFO("[mount] pages failed!");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _partition_cnt; ++i)
+    {
+        if (_pPartition[i].mount == nullptr)
+        {
+            continue;
+        }
+
+        if (!_pPartition[i].mount(_pPartition[i].pRegion, formatOnFail))
+        {
+            FPM_TAG_INFO("[mount] %s failed!", _pPartition[i].name);
+            status_isOK = false;
+        }
+    }
+
+    return status_isOK;
+} // mount
+
+/**
+ * Return the index of partition, -1 if not found
+*/
+int16_t FlashPartitionManager::find(const char *name)
+{
+    for (uint8_t i = 0; i < _partition_cnt; ++i)
+    {
+        if ((_pPartition[i].name != nullptr) && (0 == strcmp(_pPartition[i].name, name)))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+} // find
+
+uint32_t FlashPartitionManager::start(uint8_t index)
+{
+    return (index < _partition_cnt) ? _pPartition[index].start : PARTITION_ADDR_INVALID;
+} // start
+
+uint32_t FlashPartitionManager::size(uint8_t index)
+{
+    return (index < _partition_cnt) ? _pPartition[index].size : 0;
+} // size
+
+/**
+ * Return the page erase size of regions, the page header is excluded in wear levelling mode
+*/
+uint16_t FlashPartitionManager::page()
+{
+    return _page_size;
+} // page
+
+/**
+ * Return the number of pages are not in any partition
+*/
+uint32_t FlashPartitionManager::sparePages()
+{
+    return (_device_size - _used_size) / _page_erase_size;
+} // sparePages
+
+uint32_t FlashPartitionManager::eraseCount(uint16_t page)
+{
+    return (_wear_levelling && (_pEraseCount != nullptr) && (page < _physical_cnt)) ? _pEraseCount[page] : 0;
+} // eraseCount
+
+uint32_t FlashPartitionManager::eraseCountMax()
+{
+    uint32_t count_max = 0;
+
+    for (uint16_t page = 0; page < _physical_cnt; ++page)
+    {
+        if (eraseCount(page) > count_max)
+        {
+            count_max = eraseCount(page);
+        }
+    }
+
+    return count_max;
+} // eraseCountMax
+
+uint16_t FlashPartitionManager::badPages()
+{
+    uint16_t count = 0;
+
+    for (uint16_t page = 0; (_pOwner != nullptr) && (page < _physical_cnt); ++page)
+    {
+        if (PARTITION_PAGE_BAD == _pOwner[page])
+        {
+            ++count;
+        }
+    }
+
+    return count;
+} // badPages
+
+/**
+ * @brief Enable static wear levelling of wear levelling mode.
+ * @param [in] threshold Move the coldest page if its erase count is less than maximum by threshold, 0 is disabled.
+ * @param [in] interval The number of page erases between two moves, the foreground writes are not delayed.
+ */
+void FlashPartitionManager::setStaticLevelling(uint32_t threshold, uint32_t interval)
+{
+    _static_threshold = threshold;
+    _static_interval = interval;
+} // setStaticLevelling
+
+/**
+ * @brief Static wear levelling pass, call it when the application is idle. At most one page is moved.
+ * @return False if moving page failed
+ */
+bool FlashPartitionManager::idle()
+{
+    uint32_t count_max = 0;
+    uint16_t page, cold = PARTITION_PAGE_NONE, target;
+
+    if (!_wear_levelling || (0 == _static_threshold) || (_pMap == nullptr) || (_erase_since_static < _static_interval))
+    {
+        return true;
+    }
+
+    for (page = 0; page < _physical_cnt; ++page)
+    {
+        if (PARTITION_PAGE_BAD == _pOwner[page])
+        {
+            continue;
+        }
+
+        if (_pEraseCount[page] > count_max)
+        {
+            count_max = _pEraseCount[page];
+        }
+
+        if ((PARTITION_PAGE_NONE != _pOwner[page])
+            && ((PARTITION_PAGE_NONE == cold) || (_pEraseCount[page] < _pEraseCount[cold])))
+        {
+            cold = page;
+        }
+    }
+
+    target = freePage(true);
+    if ((PARTITION_PAGE_NONE == cold) || (PARTITION_PAGE_NONE == target)
+        || ((count_max - _pEraseCount[cold]) < _static_threshold)
+        || (_pEraseCount[target] <= _pEraseCount[cold]))
+    {
+        return true;
+    }
+
+    _erase_since_static = 0;
+    return relocatePage(cold, true);
+} // idle
+
+bool FlashPartitionManager::onRead(uint32_t addr, uint8_t *buff, uint32_t *length)
+{
+    if (!inPartition(addr, *length))
+    {
+        FPM_TAG_INFO("[onRead] %u(0x%X) out of partition!", addr, addr);
+        return false;
+    }
+
+    if (_wear_levelling)
+    {
+        return access(addr, buff, length, false);
+    }
+
+    return _pCallbacks->onRead(addr, buff, length);
+} // onRead
+
+/**
+ * The program and erase are scheduled one by one, the device is ready before each
+*/
+bool FlashPartitionManager::onWrite(uint32_t addr, uint8_t *buff, uint32_t *length)
+{
+    if (!inPartition(addr, *length))
+    {
+        FPM_TAG_INFO("[onWrite] %u(0x%X) out of partition!", addr, addr);
+        return false;
+    }
+
+    if (!_pCallbacks->onReady())
+    {
+        FPM_TAG_INFO("[onWrite] device is not ready!");
+        return false;
+    }
+
+    if (_wear_levelling)
+    {
+        return access(addr, buff, length, true);
+    }
+
+    return _pCallbacks->onWrite(addr, buff, length);
+} // onWrite
+
+bool FlashPartitionManager::onErase(uint32_t addr, uint32_t length)
+{
+    if (!inPartition(addr, length) || (addr % _page_size) || (length % _page_size))
+    {
+        FPM_TAG_INFO("[onErase] %u(0x%X) out of partition!", addr, addr);
+        return false;
+    }
+
+    if (!_pCallbacks->onReady())
+    {
+        FPM_TAG_INFO("[onErase] device is not ready!");
+        return false;
+    }
+
+    if (_wear_levelling)
+    {
+        for (uint32_t offset = 0; offset < length; offset += _page_size)
+        {
+            if (!allocatePage((addr + offset) / _page_size))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return _pCallbacks->onErase(addr, length);
+} // onErase
+
+/**
+ * The block erase sizes of device, a page of wear levelling mode is erased alone
+*/
+uint32_t FlashPartitionManager::onEraseSizes()
+{
+    return _wear_levelling ? 0 : _pCallbacks->onEraseSizes();
+} // onEraseSizes
+
+/**
+ * The pages of wear levelling mode are programmed once after an erase
+*/
+bool FlashPartitionManager::onInPlaceWrite()
+{
+    return _wear_levelling ? false : _pCallbacks->onInPlaceWrite();
+} // onInPlaceWrite
+
+bool FlashPartitionManager::onReady()
+{
+    return _pCallbacks->onReady();
+} // onReady
+
+void FlashPartitionManager::onStatus(status_t s)
+{
+    _pCallbacks->onStatus(s);
+} // onStatus
+
+/**
+ * @brief The range is inside one partition.
+ */
+bool FlashPartitionManager::inPartition(uint32_t addr, uint32_t length)
+{
+    for (uint8_t i = 0; i < _partition_cnt; ++i)
+    {
+        if ((addr >= _pPartition[i].start) && (addr < (_pPartition[i].start + _pPartition[i].size)))
+        {
+            return length <= ((_pPartition[i].start + _pPartition[i].size) - addr);
+        }
+    }
+
+    return false;
+} // inPartition
+
+/**
+ * @brief Read the header of all pages, the newest sequence of a logical page is mapped.
+ */
+bool FlashPartitionManager::mountPages()
+{
+    page_header_t header;
+    uint32_t length, count_max = 0;
+    uint16_t page;
+
+    _sequence = 0;
+    for (page = 0; page < _logical_cnt; ++page)
+    {
+        _pMap[page] = PARTITION_PAGE_NONE;
+    }
+
+    for (page = 0; page < _physical_cnt; ++page)
+    {
+        _pOwner[page] = PARTITION_PAGE_NONE;
+        _pEraseCount[page] = 0;
+
+        if (_pCallbacks->onBadBlock(_start_addr + page * _page_erase_size))
+        {
+            FPM_TAG_INFO("[mountPages] factory bad page %u", page);
+            _pOwner[page] = PARTITION_PAGE_BAD;
+            continue;
+        }
+
+        length = PAGE_HEADER_LENGTH;
+        if (!_pCallbacks->onRead(_start_addr + page * _page_erase_size, (uint8_t *)&header, &length)
+            || (length != PAGE_HEADER_LENGTH))
+        {
+            FPM_TAG_INFO("[mountPages] Read header failed!");
+            return false;
+        }
+
+        if ((PAGE_BAD_MAGIC == header.magic) && (pageCrc32(&header) == header.crc32))
+        {
+            FPM_TAG_INFO("[mountPages] bad page %u", page);
+            _pOwner[page] = PARTITION_PAGE_BAD;
+            _pEraseCount[page] = header.eraseCount;
+            continue;
+        }
+
+        if ((PAGE_HEADER_MAGIC != header.magic) || (pageCrc32(&header) != header.crc32))
+        {
+            /* The erase count of a blank or broken header is not known, a page erased may lose
+                its header by a power lost */
+            _pEraseCount[page] = UINT32_MAX;
+            continue;
+        }
+
+        _pEraseCount[page] = header.eraseCount;
+        if (header.eraseCount > count_max)
+        {
+            count_max = header.eraseCount;
+        }
+        if ((header.sequence + 1U) > _sequence)
+        {
+            _sequence = header.sequence + 1U;
+        }
+
+        if (header.logicalPage >= _logical_cnt)
+        {
+            continue;
+        }
+
+        /* The older page of a logical page is free */
+        if (PARTITION_PAGE_NONE != _pMap[header.logicalPage])
+        {
+            uint16_t other = _pMap[header.logicalPage];
+            page_header_t other_header;
+            length = PAGE_HEADER_LENGTH;
+            if (!_pCallbacks->onRead(_start_addr + other * _page_erase_size, (uint8_t *)&other_header, &length)
+                || (length != PAGE_HEADER_LENGTH))
+            {
+                return false;
+            }
+            if ((int32_t)(header.sequence - other_header.sequence) < 0)
+            {
+                continue;
+            }
+            _pOwner[other] = PARTITION_PAGE_NONE;
+        }
+
+        _pMap[header.logicalPage] = page;
+        _pOwner[page] = header.logicalPage;
+    }
+
+    for (page = 0; page < _physical_cnt; ++page)
+    {
+        if (UINT32_MAX == _pEraseCount[page])
+        {
+            _pEraseCount[page] = count_max;
+        }
+    }
+
+    FPM_TAG_INFO("[mountPages] sequence %u, erase count max %u", _sequence, count_max);
+    return true;
+} // mountPages
+
+/**
+ * @brief Move a logical page to the least worn free page, the page is erased
+ *        and the header is written before the map is changed. A page failed
+ *        is marked bad and the next free page is tried.
+ */
+bool FlashPartitionManager::allocatePage(uint16_t logical)
+{
+    uint16_t target;
+
+    for (;;)
+    {
+        target = freePage(false);
+        if (PARTITION_PAGE_NONE == target)
+        {
+            FPM_TAG_INFO("[allocatePage] no free page!");
+            return false;
+        }
+
+        if (!_pCallbacks->onErase(_start_addr + target * _page_erase_size, _page_erase_size))
+        {
+            FPM_TAG_INFO("[allocatePage] erase page %u failed!", target);
+            markBad(target);
+            continue;
+        }
+        ++_pEraseCount[target];
+        ++_erase_since_static;
+
+        if (!writePageHeader(target, PAGE_HEADER_MAGIC, logical))
+        {
+            FPM_TAG_INFO("[allocatePage] write header page %u failed!", target);
+            markBad(target);
+            continue;
+        }
+        break;
+    }
+
+    if (PARTITION_PAGE_NONE != _pMap[logical])
+    {
+        _pOwner[_pMap[logical]] = PARTITION_PAGE_NONE;
+    }
+    _pMap[logical] = target;
+    _pOwner[target] = logical;
+
+    FPM_TAG_INFO("[allocatePage] logical %u -> page %u, erase count %u", logical, target, _pEraseCount[target]);
+    return true;
+} // allocatePage
+
+/**
+ * @brief The free page of the lowest erase count, or the highest if worn.
+ * @return PARTITION_PAGE_NONE if no page is free
+ */
+uint16_t FlashPartitionManager::freePage(bool worn)
+{
+    uint16_t page, target = PARTITION_PAGE_NONE;
+
+    for (page = 0; page < _physical_cnt; ++page)
+    {
+        if ((PARTITION_PAGE_NONE == _pOwner[page])
+            && ((PARTITION_PAGE_NONE == target)
+                || (worn ? (_pEraseCount[page] > _pEraseCount[target]) : (_pEraseCount[page] < _pEraseCount[target]))))
+        {
+            target = page;
+        }
+    }
+
+    return target;
+} // freePage
+
+/**
+ * @brief Never allocate the page again. The bad page header is written at best,
+ *        if it is not written the page is found bad again by the next erase.
+ */
+void FlashPartitionManager::markBad(uint16_t page)
+{
+    FPM_TAG_INFO("[markBad] page %u", page);
+    _pOwner[page] = PARTITION_PAGE_BAD;
+    if (_pCallbacks->onErase(_start_addr + page * _page_erase_size, _page_erase_size))
+    {
+        writePageHeader(page, PAGE_BAD_MAGIC, PARTITION_PAGE_NONE);
+    }
+} // markBad
+
+bool FlashPartitionManager::writePageHeader(uint16_t page, uint16_t magic, uint16_t logical)
+{
+    page_header_t header;
+    uint32_t length = PAGE_HEADER_LENGTH;
+
+    header.magic = magic;
+    header.logicalPage = logical;
+    header.eraseCount = _pEraseCount[page];
+    header.sequence = _sequence;
+    header.crc32 = pageCrc32(&header);
+    if (!_pCallbacks->onReady()
+        || !_pCallbacks->onWrite(_start_addr + page * _page_erase_size, (uint8_t *)&header, &length)
+        || (length != PAGE_HEADER_LENGTH))
+    {
+        return false;
+    }
+
+    ++_sequence;
+    return true;
+} // writePageHeader
+
+uint32_t FlashPartitionManager::pageCrc32(page_header_t *header)
+{
+    return Crc32_CalculateBuffer((uint8_t *)header, PAGE_HEADER_LENGTH - sizeof(uint32_t));
+} // pageCrc32
+
+/**
+ * @brief Read or write logical address, split by logical page. A logical page
+ *        not mapped is read as erased and mapped before it is written.
+ */
+bool FlashPartitionManager::access(uint32_t addr, uint8_t *buff, uint32_t *length, bool isWrite)
+{
+    uint32_t offset, chunk, chunk_length, phys_addr;
+    uint16_t logical;
+
+    for (offset = 0; offset < (*length); offset += chunk)
+    {
+        logical = (addr + offset) / _page_size;
+        chunk = _page_size - ((addr + offset) % _page_size);
+        if (chunk > ((*length) - offset))
+        {
+            chunk = (*length) - offset;
+        }
+
+        if (PARTITION_PAGE_NONE == _pMap[logical])
+        {
+            if (!isWrite)
+            {
+                memset(buff + offset, 0xFF, chunk);
+                continue;
+            }
+
+            if (!allocatePage(logical))
+            {
+                return false;
+            }
+        }
+
+        phys_addr = _start_addr + _pMap[logical] * _page_erase_size + PAGE_HEADER_LENGTH + ((addr + offset) % _page_size);
+        chunk_length = chunk;
+        if (isWrite && (!_pCallbacks->onWrite(phys_addr, buff + offset, &chunk_length) || (chunk_length != chunk)))
+        {
+            /* Move the data programmed to the next good page and retry, the range failed is not copied */
+            uint16_t page = _pMap[logical];
+            FPM_TAG_INFO("[access] write page %u failed, retry", page);
+            if (!relocatePage(page, false, PAGE_HEADER_LENGTH + ((addr + offset) % _page_size), chunk))
+            {
+                return false;
+            }
+            markBad(page);
+
+            phys_addr = _start_addr + _pMap[logical] * _page_erase_size + PAGE_HEADER_LENGTH + ((addr + offset) % _page_size);
+            chunk_length = chunk;
+            if (!_pCallbacks->onWrite(phys_addr, buff + offset, &chunk_length))
+            {
+                return false;
+            }
+        }
+        else if (!isWrite && !_pCallbacks->onRead(phys_addr, buff + offset, &chunk_length))
+        {
+            return false;
+        }
+
+        if (chunk_length != chunk)
+        {
+            FPM_TAG_INFO("[access] length failed!");
+            return false;
+        }
+    }
+
+    return true;
+} // access
+
+/**
+ * @brief Copy a page to a free page, the header is written after the data, so a power lost
+ *        keep the old page. A target page failed is marked bad and the next free page is tried.
+ * @param [in] page The physical page is moved, it become free.
+ * @param [in] worn Copy to the most worn free page, else the least worn.
+ * @param [in] skip_offset The offset in page of a range is not copied, it stay erased.
+ * @param [in] skip_length The length of range is not copied, 0 copy the whole page.
+ */
+bool FlashPartitionManager::relocatePage(uint16_t page, bool worn, uint32_t skip_offset, uint32_t skip_length)
+{
+    uint32_t length, offset, chunk, src, dst;
+    uint16_t target, logical = _pOwner[page];
+    bool status_isOK;
+
+    if (_pCopy == nullptr)
+    {
+        FPM_TAG_INFO("[relocatePage] no copy buffer!");
+        return false;
+    }
+
+    src = _start_addr + page * _page_erase_size;
+    do
+    {
+        target = freePage(worn);
+        if (PARTITION_PAGE_NONE == target)
+        {
+            FPM_TAG_INFO("[relocatePage] no free page!");
+            return false;
+        }
+
+        dst = _start_addr + target * _page_erase_size;
+        status_isOK = _pCallbacks->onErase(dst, _page_erase_size);
+        if (status_isOK)
+        {
+            ++_pEraseCount[target];
+        }
+
+        for (offset = PAGE_HEADER_LENGTH; status_isOK && (offset < _page_erase_size); offset += chunk)
+        {
+            /* The range of a write failed is half programmed, it is written again after */
+            if ((skip_length > 0) && (offset == skip_offset))
+            {
+                chunk = skip_length;
+                continue;
+            }
+
+            chunk = _page_erase_size - offset;
+            if (chunk > HISTORY_PREFETCH_SIZE_DEFAULT)
+            {
+                chunk = HISTORY_PREFETCH_SIZE_DEFAULT;
+            }
+            if ((skip_length > 0) && (offset < skip_offset) && ((offset + chunk) > skip_offset))
+            {
+                chunk = skip_offset - offset;
+            }
+
+            length = chunk;
+            if (!_pCallbacks->onRead(src + offset, _pCopy, &length) || (length != chunk))
+            {
+                FPM_TAG_INFO("[relocatePage] read failed!");
+                return false;
+            }
+
+            length = chunk;
+            status_isOK = _pCallbacks->onReady() && _pCallbacks->onWrite(dst + offset, _pCopy, &length) && (length == chunk);
+        }
+
+        if (!status_isOK || !writePageHeader(target, PAGE_HEADER_MAGIC, logical))
+        {
+            FPM_TAG_INFO("[relocatePage] page %u failed!", target);
+            markBad(target);
+            status_isOK = false;
+        }
+    } while (!status_isOK);
+
+    _pOwner[page] = PARTITION_PAGE_NONE;
+    _pMap[logical] = target;
+    _pOwner[target] = logical;
+
+    FPM_TAG_INFO("[relocatePage] logical %u page %u -> %u, erase count %u", logical, page, target, _pEraseCount[target]);
+    return true;
+} // relocatePage
@@ -0,0 +1,174 @@
+/** @file FlashPartitionManager.h
+ *  @brief utility support sharing one flash device between many regions,
+ *         the regions are carved from a partition table
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_PARTITION_MANAGER_H
+#define __FLASH_PARTITION_MANAGER_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define PARTITION_ADDR_INVALID 0xFFFFFFFFU
+#define PARTITION_PAGE_NONE 0xFFFFU
+#define PARTITION_PAGE_BAD 0xFFFEU
+
+#define FPM_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FPM]", __VA_ARGS__)
+
+typedef struct
+{
+    const char *name;
+    uint32_t size; /* multiples page erase size */
+} partition_t;
+
+/**
+ * The partitions are placed in table order from the start address of device,
+ * the pages after the last partition are spare.
+ * All regions attached use the manager as callbacks, the manager check the
+ * address of partition and forward in order to the callbacks of device.
+ *
+ * Example:
+ *  const partition_t table[] = {{"config", 8192}, {"log", 65536}};
+ *  FlashPartitionManager flash(0, 1024 * 1024, 4096);
+ *  flash.setTable(table, 2);
+ *  FlashKeyValueStore config(flash.start(0), flash.size(0), flash.page());
+ *  flash.attach(0, &config);
+ *  flash.mount(true);
+ *
+ * Wear levelling mode: every page of device start with a page header (erase count,
+ * logical page, sequence), the regions see pages of (page erase size - 16) byte.
+ * An erase of a logical page move it to the least worn free page of device, the
+ * spare pages are shared by all partitions. Mount read one header per page.
+ *
+ * Static wear levelling: a page written once is never erased again. Call idle() when the
+ * application is idle, if the erase count skew of the coldest page is over the threshold,
+ * it is copied to the most worn free page, the cold page become free for the hot data.
+ * One page is moved per call and only after a number of erases since the last move.
+ *
+ * Bad blocks (NAND): a page is bad if the backend report it by onBadBlock() (factory marker)
+ * or if an erase or a program of it failed. A bad page is marked by a bad page header,
+ * it is never allocated again, the erase or the write is retried on the next good page.
+ */
+class FlashPartitionManager : public FlashWearLevellingCallbacks
+{
+    typedef bool (*mount_t)(void *pRegion, bool formatOnFail);
+
+    typedef struct
+    {
+        uint32_t start;
+        uint32_t size;
+        const char *name;
+        void *pRegion;
+        mount_t mount;
+    } partition_cxt_t;
+
+    typedef enum
+    {
+        PAGE_HEADER_MAGIC = 0x5AA5,
+        PAGE_BAD_MAGIC = 0x0BAD,
+        PAGE_HEADER_LENGTH = 16
+    } pageType_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint16_t magic;
+        uint16_t logicalPage;
+        uint32_t eraseCount;
+        uint32_t sequence;
+        uint32_t crc32; /* magic, logical page, erase count and sequence */
+    } page_header_t;
+
+public:
+    FlashPartitionManager(uint32_t start_addr,
+                          size_t device_size,
+                          uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT,
+                          bool wear_levelling = false);
+    ~FlashPartitionManager();
+    void setCallbacks(FlashWearLevellingCallbacks *pCallbacks);
+    bool setTable(const partition_t *table, uint8_t count);
+    bool mount(bool formatOnFail = false);
+    int16_t find(const char *name);
+    uint32_t start(uint8_t index);
+    uint32_t size(uint8_t index);
+    uint16_t page();
+    uint32_t sparePages();
+    /* The erase count of a physical page in wear levelling mode, 0 if it is not known */
+    uint32_t eraseCount(uint16_t page);
+    uint32_t eraseCountMax();
+    uint16_t badPages();
+    void setStaticLevelling(uint32_t threshold, uint32_t interval = 16);
+    bool idle();
+
+    /* The region is constructed with start(index), size(index) and page() */
+    template <typename regionType>
+    bool attach(uint8_t index, regionType *region)
+    {
+        if ((index >= _partition_cnt) || (region == nullptr))
+        {
+            return false;
+        }
+
+        region->setCallbacks(this);
+        _pPartition[index].pRegion = region;
+        _pPartition[index].mount = &FlashPartitionManager::mountRegion<regionType>;
+        return true;
+    } // attach
+
+    bool onRead(uint32_t addr, uint8_t *buff, uint32_t *length) override;
+    bool onWrite(uint32_t addr, uint8_t *buff, uint32_t *length) override;
+    bool onErase(uint32_t addr, uint32_t length) override;
+    bool onReady() override;
+    void onStatus(status_t s) override;
+    uint32_t onEraseSizes() override;
+    bool onInPlaceWrite() override;
+
+private:
+    const uint32_t _start_addr;
+    const size_t _device_size;
+    const uint16_t _page_erase_size;
+    const bool _wear_levelling;
+    const uint16_t _page_size; /* the page of regions */
+    partition_cxt_t *_pPartition;
+    uint8_t _partition_cnt;
+    uint32_t _used_size;
+    uint8_t *_pScratch;
+    uint8_t *_pCopy; /* relocatePage(), never the shared scratch of regions */
+    FlashWearLevellingCallbacks *_pCallbacks;
+    uint16_t _physical_cnt;
+    uint16_t _logical_cnt;
+    uint16_t *_pMap;         /* logical page to physical page */
+    uint16_t *_pOwner;       /* physical page to logical page, PARTITION_PAGE_NONE if free, PARTITION_PAGE_BAD */
+    uint32_t *_pEraseCount;  /* of physical page */
+    uint32_t _sequence;
+    uint32_t _static_threshold; /* 0 is disabled */
+    uint32_t _static_interval;
+    uint32_t _erase_since_static;
+    bool inPartition(uint32_t addr, uint32_t length);
+    bool mountPages();
+    bool allocatePage(uint16_t logical);
+    bool relocatePage(uint16_t page, bool worn, uint32_t skip_offset = 0, uint32_t skip_length = 0);
+    uint16_t freePage(bool worn);
+    void markBad(uint16_t page);
+    bool writePageHeader(uint16_t page, uint16_t magic, uint16_t logical);
+    uint32_t pageCrc32(page_header_t *header);
+    bool access(uint32_t addr, uint8_t *buff, uint32_t *length, bool isWrite);
+
+    template <typename regionType>
+    static bool mountRegion(void *pRegion, bool formatOnFail)
+    {
+        return ((regionType *)pRegion)->begin(formatOnFail);
+    } // mountRegion
+};
+
+#endif
@@ -0,0 +1,342 @@
+/** @file FlashSerializer.h
+ *  @brief the encoding of a variable to the data of a record, integers are
+ *         varint/zigzag and containers are length-prefixed
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_SERIALIZER_H
+#define __FLASH_SERIALIZER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <limits>
+
+/**
+ * The customization point, specialize it for a structure to skip padding bytes
+ * or to store std::string/std::vector members. Example:
+ *
+ *  template <>
+ *  struct FlashSerializer<calib_t>
+ *  {
+ *      static bool encode(FlashWriter &w, const calib_t &v) { return w.put(v.gain) && w.put(v.name); }
+ *      static bool decode(FlashReader &r, calib_t *v) { return r.get(&v->gain) && r.get(&v->name); }
+ *  };
+ *
+ * Without specialization a trivially copyable type is stored as sizeof(T) bytes.
+ */
+template <typename T, typename Enable = void>
+struct FlashSerializer;
+
+class FlashWriter
+{
+public:
+    FlashWriter(uint8_t *buff, uint32_t size) : _pBuffer(buff), _size(size), _length(0) {}
+
+    bool putBytes(const void *data, uint32_t length)
+    {
+        if ((_size - _length) < length)
+        {
+            return false;
+        }
+        memcpy(_pBuffer + _length, data, length);
+        _length += length;
+        return true;
+    } // putBytes
+
+    /* 7-bit per byte, the MSB is set if more byte follow */
+    bool putVarint(uint64_t value)
+    {
+        do
+        {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            if (value)
+            {
+                byte |= 0x80;
+            }
+            if (!putBytes(&byte, 1))
+            {
+                return false;
+            }
+        } while (value);
+        return true;
+    } // putVarint
+
+    /* Small negative number is encoded to small varint */
+    bool putZigzag(int64_t value)
+    {
+        return putVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    } // putZigzag
+
+    template <typename T>
+    bool put(const T &value)
+    {
+        return FlashSerializer<T>::encode(*this, value);
+    } // put
+
+    uint32_t length() const
+    {
+        return _length;
+    } // length
+
+private:
+    uint8_t *_pBuffer;
+    uint32_t _size;
+    uint32_t _length;
+};
+
+class FlashReader
+{
+public:
+    FlashReader(const uint8_t *buff, uint32_t length) : _pBuffer(buff), _length(length), _offset(0) {}
+
+    bool getBytes(void *data, uint32_t length)
+    {
+        if ((_length - _offset) < length)
+        {
+            return false;
+        }
+        memcpy(data, _pBuffer + _offset, length);
+        _offset += length;
+        return true;
+    } // getBytes
+
+    bool getVarint(uint64_t *value)
+    {
+        uint8_t byte;
+
+        *value = 0;
+        for (uint8_t shift = 0; shift < 64; shift += 7)
+        {
+            if (!getBytes(&byte, 1))
+            {
+                return false;
+            }
+            *value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    } // getVarint
+
+    bool getZigzag(int64_t *value)
+    {
+        uint64_t raw;
+
+        if (!getVarint(&raw))
+        {
+            return false;
+        }
+        *value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+        return true;
+    } // getZigzag
+
+    template <typename T>
+    bool get(T *value)
+    {
+        return FlashSerializer<T>::decode(*this, value);
+    } // get
+
+    uint32_t remaining() const
+    {
+        return _length - _offset;
+    } // remaining
+
+    /* All data is decoded */
+    bool isEnd() const
+    {
+        return _offset == _length;
+    } // isEnd
+
+private:
+    const uint8_t *_pBuffer;
+    uint32_t _length;
+    uint32_t _offset;
+};
+
+/* Raw bytes, the default of a trivially copyable type */
+template <typename T, typename Enable>
+struct FlashSerializer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "specialize FlashSerializer<T> for this type");
+
+    static bool encode(FlashWriter &w, const T &value)
+    {
+        return w.putBytes(&value, sizeof(T));
+    } // encode
+
+    static bool decode(FlashReader &r, T *value)
+    {
+        return r.getBytes(value, sizeof(T));
+    } // decode
+};
+
+template <>
+struct FlashSerializer<bool>
+{
+    static bool encode(FlashWriter &w, const bool &value)
+    {
+        uint8_t byte = value ? 1 : 0;
+        return w.putBytes(&byte, 1);
+    } // encode
+
+    static bool decode(FlashReader &r, bool *value)
+    {
+        uint8_t byte;
+        if (!r.getBytes(&byte, 1) || (byte > 1))
+        {
+            return false;
+        }
+        *value = (byte != 0);
+        return true;
+    } // decode
+};
+
+/* Unsigned integer, varint */
+template <typename T>
+struct FlashSerializer<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value
+                                                  && !std::is_same<T, bool>::value>::type>
+{
+    static bool encode(FlashWriter &w, const T &value)
+    {
+        return w.putVarint(value);
+    } // encode
+
+    static bool decode(FlashReader &r, T *value)
+    {
+        uint64_t raw;
+        if (!r.getVarint(&raw) || (raw > (uint64_t)std::numeric_limits<T>::max()))
+        {
+            return false;
+        }
+        *value = (T)raw;
+        return true;
+    } // decode
+};
+
+/* Signed integer, zigzag varint */
+template <typename T>
+struct FlashSerializer<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type>
+{
+    static bool encode(FlashWriter &w, const T &value)
+    {
+        return w.putZigzag(value);
+    } // encode
+
+    static bool decode(FlashReader &r, T *value)
+    {
+        int64_t raw;
+        if (!r.getZigzag(&raw)
+            || (raw > (int64_t)std::numeric_limits<T>::max())
+            || (raw < (int64_t)std::numeric_limits<T>::min()))
+        {
+            return false;
+        }
+        *value = (T)raw;
+        return true;
+    } // decode
+};
+
+/* Enum, the underlying integer */
+template <typename T>
+struct FlashSerializer<T, typename std::enable_if<std::is_enum<T>::value>::type>
+{
+    typedef typename std::underlying_type<T>::type underlying_t;
+
+    static bool encode(FlashWriter &w, const T &value)
+    {
+        return FlashSerializer<underlying_t>::encode(w, (underlying_t)value);
+    } // encode
+
+    static bool decode(FlashReader &r, T *value)
+    {
+        underlying_t raw;
+        if (!FlashSerializer<underlying_t>::decode(r, &raw))
+        {
+            return false;
+        }
+        *value = (T)raw;
+        return true;
+    } // decode
+};
+
+/* Length-prefixed string */
+template <>
+struct FlashSerializer<std::string>
+{
+    static bool encode(FlashWriter &w, const std::string &value)
+    {
+        return w.putVarint(value.size()) && w.putBytes(value.data(), value.size());
+    } // encode
+
+    static bool decode(FlashReader &r, std::string *value)
+    {
+        uint32_t length;
+        if (!r.get(&length) || (length > r.remaining()))
+        {
+            return false;
+        }
+        value->resize(length);
+        return r.getBytes(&(*value)[0], length);
+    } // decode
+};
+
+/* Length-prefixed vector, each element by its serializer */
+template <typename T, typename A>
+struct FlashSerializer<std::vector<T, A>>
+{
+    static bool encode(FlashWriter &w, const std::vector<T, A> &value)
+    {
+        if (!w.putVarint(value.size()))
+        {
+            return false;
+        }
+        for (const T &element : value)
+        {
+            if (!w.put(element))
+            {
+                return false;
+            }
+        }
+        return true;
+    } // encode
+
+    static bool decode(FlashReader &r, std::vector<T, A> *value)
+    {
+        uint32_t count;
+        /* Each element is one byte at least */
+        if (!r.get(&count) || (count > r.remaining()))
+        {
+            return false;
+        }
+        value->clear();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            T element;
+            if (!r.get(&element))
+            {
+                return false;
+            }
+            value->push_back(element);
+        }
+        return true;
+    } // decode
+};
+
+#endif // __FLASH_SERIALIZER_H
@@ -0,0 +1,330 @@
+#include "FlashSlotVar.h"
+#include "util_crc32.h"
+
+FlashSlotVar::
+    FlashSlotVar(uint32_t start_addr,
+                 size_t memory_size,
+                 uint16_t page_erase_size,
+                 uint32_t data_length,
+                 uint16_t slot_count) : _start_addr(start_addr),
+                                        _memory_size(memory_size),
+                                        _page_erase_size(page_erase_size),
+                                        _data_length(data_length),
+                                        _slot_count(slot_count),
+                                        _slot_size(page_erase_size ? (((SLOT_HEADER_LENGTH + data_length + page_erase_size - 1U) / page_erase_size) * page_erase_size) : 0),
+                                        _pHeader(nullptr),
+                                        _current(SLOT_NONE),
+                                        _generation_next(0)
+{
+    _pCallbacks = &defaultCallback;
+} // FlashSlotVar
+
+FlashSlotVar::~FlashSlotVar()
+{
+    delete[] _pHeader; /* free memory */
+} // ~FlashSlotVar
+
+/**
+ * @brief Set the callback handlers for this flash memory.
+ * @param [in] pCallbacks An instance of a callbacks structure used to define any callbacks for the flash memory.
+ */
+void FlashSlotVar::setCallbacks(FlashWearLevellingCallbacks *pCallbacks)
+{
+    if (pCallbacks != nullptr)
+    {
+        _pCallbacks = pCallbacks;
+    }
+    else
+    {
+        _pCallbacks = &defaultCallback;
+    }
+} // setCallbacks
+
+/**
+ * Read the header of each slot, the newest generation is the current slot
+*/
+bool FlashSlotVar::begin(bool formatOnFail)
+{
+    uint32_t length;
+
+    if (!verifyMemInfo())
+    {
+        FSV_TAG_INFO("[begin] memory info Failed!");
+        return false;
+    }
+
+    if (_pHeader == nullptr)
+    {
+        _pHeader = new (std::nothrow) slot_header_t[_slot_count];
+        if (_pHeader == nullptr)
+        {
+            FSV_TAG_INFO("[begin] Allocate RAM failed!");
+            return false;
+        }
+    }
+
+    _generation_next = 0;
+    for (uint16_t slot = 0; slot < _slot_count; ++slot)
+    {
+        length = SLOT_HEADER_LENGTH;
+        if (!_pCallbacks->onRead(slotAddr(slot), (uint8_t *)&_pHeader[slot], &length) || (length != SLOT_HEADER_LENGTH))
+        {
+            FSV_TAG_INFO("[begin] Read header failed!");
+            return false;
+        }
+
+        if (!slotValid(&_pHeader[slot]))
+        {
+            _pHeader[slot].crc32 = SLOT_BLANK;
+        }
+        else if (_pHeader[slot].generation >= _generation_next)
+        {
+            _generation_next = _pHeader[slot].generation + 1U;
+        }
+    }
+
+    _current = slotNewest();
+    if (SLOT_NONE == _current)
+    {
+        FSV_TAG_INFO("[begin] Not Found slot");
+        return formatOnFail ? format() : false;
+    }
+
+    FSV_TAG_INFO("[begin] slot %u generation %u", _current, _pHeader[_current].generation);
+    return true;
+} // begin
+
+/**
+ * Format memory type as factory, the slots have header are erased
+*/
+bool FlashSlotVar::format()
+{
+    slot_header_t header;
+    uint32_t length;
+
+    if (_pHeader == nullptr)
+    {
+        return false;
+    }
+
+    for (uint16_t slot = 0; slot < _slot_count; ++slot)
+    {
+        length = SLOT_HEADER_LENGTH;
+        if (!_pCallbacks->onRead(slotAddr(slot), (uint8_t *)&header, &length) || (length != SLOT_HEADER_LENGTH))
+        {
+            FSV_TAG_INFO("[format] Read header failed!");
+            return false;
+        }
+
+        if (((SLOT_BLANK != header.crc32) || (SLOT_BLANK != header.generation) || (SLOT_BLANK != header.length))
+            && !_pCallbacks->eraseRange(slotAddr(slot), _slot_size, _page_erase_size))
+        {
+            FSV_TAG_INFO("[format] erase failed!");
+            return false;
+        }
+
+        _pHeader[slot].crc32 = SLOT_BLANK;
+    }
+
+    _current = SLOT_NONE;
+    _generation_next = 0;
+    return true;
+} // format
+
+/** Write data into the slot after the current slot, one erase per write
+ *
+ *  @param buff     Buffer of data to write
+ *  @param length   Size to write in bytes, data length at most
+ *  @return         True if write is succeed
+ */
+bool FlashSlotVar::write(uint8_t *buff, uint32_t *length)
+{
+    slot_header_t header;
+    uint32_t write_length;
+    uint16_t slot;
+
+    if ((_pHeader == nullptr) || (0 == (*length)) || ((*length) > _data_length))
+    {
+        FSV_TAG_INFO("[write] length failed!");
+        return false;
+    }
+
+    /* A generation is never used again, even the slot of it is broken */
+    slot = slotTarget();
+    header.generation = _generation_next;
+    header.length = *length;
+    header.crc32 = slotCrc32(&header, buff);
+
+    FSV_TAG_INFO("[write] slot %u generation %u", slot, header.generation);
+    _pHeader[slot].crc32 = SLOT_BLANK;
+    if (!_pCallbacks->eraseRange(slotAddr(slot), _slot_size, _page_erase_size))
+    {
+        FSV_TAG_INFO("[write] erase failed!");
+        return false;
+    }
+
+    /* The header is the last, a slot with header have all data */
+    write_length = *length;
+    if (!_pCallbacks->onWrite(slotAddr(slot) + SLOT_HEADER_LENGTH, buff, &write_length) || (write_length != (*length)))
+    {
+        FSV_TAG_INFO("[write] write data failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+        return false;
+    }
+
+    write_length = SLOT_HEADER_LENGTH;
+    if (!_pCallbacks->onWrite(slotAddr(slot), (uint8_t *)&header, &write_length) || (write_length != SLOT_HEADER_LENGTH))
+    {
+        FSV_TAG_INFO("[write] write header failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+        return false;
+    }
+
+    _pHeader[slot] = header;
+    _current = slot;
+    ++_generation_next;
+    return true;
+} // write
+
+/** Read data of the current slot, an older slot is read if CRC32 failed
+ *
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if read is succeed
+ */
+bool FlashSlotVar::read(uint8_t *buff, uint32_t *length)
+{
+    uint32_t read_length;
+    uint16_t slot = _current;
+
+    while (SLOT_NONE != slot)
+    {
+        if ((*length) < _pHeader[slot].length)
+        {
+            FSV_TAG_INFO("[read] length buffer is not enough!");
+            return false;
+        }
+
+        read_length = _pHeader[slot].length;
+        if (_pCallbacks->onRead(slotAddr(slot) + SLOT_HEADER_LENGTH, buff, &read_length)
+            && (read_length == _pHeader[slot].length)
+            && (slotCrc32(&_pHeader[slot], buff) == _pHeader[slot].crc32))
+        {
+            *length = read_length;
+            return true;
+        }
+
+        FSV_TAG_INFO("[read] slot %u CRC32 failed!", slot);
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_DATA);
+        /* The broken slot is the next write target */
+        _pHeader[slot].crc32 = SLOT_BLANK;
+        slot = slotNewest();
+        _current = slot;
+    }
+
+    return false;
+} // read
+
+/**
+ * Return the generation of the current slot
+*/
+uint32_t FlashSlotVar::generation()
+{
+    return ((_pHeader == nullptr) || (SLOT_NONE == _current)) ? SLOT_BLANK : _pHeader[_current].generation;
+} // generation
+
+/**
+ * verify memory information
+*/
+bool FlashSlotVar::verifyMemInfo()
+{
+    if ((0 == _page_erase_size) || (_start_addr % _page_erase_size))
+    {
+        FSV_TAG_INFO("[verifyMemInfo][error] _start_addr must be multiples _page_erase_size");
+        return false;
+    }
+
+    if ((0 == _data_length) || (_slot_count < 2) || (SLOT_NONE == _slot_count))
+    {
+        FSV_TAG_INFO("[verifyMemInfo][error] _data_length or _slot_count failed!");
+        return false;
+    }
+
+    if (((uint64_t)_slot_size * _slot_count) > _memory_size)
+    {
+        FSV_TAG_INFO("[verifyMemInfo][error] _memory_size is not enough, min = %u", _slot_size * _slot_count);
+        return false;
+    }
+
+    return true;
+} // verifyMemInfo
+
+uint32_t FlashSlotVar::slotAddr(uint16_t slot)
+{
+    return _start_addr + slot * _slot_size;
+} // slotAddr
+
+/**
+ * @brief CRC32 over generation, length and data.
+ */
+uint32_t FlashSlotVar::slotCrc32(slot_header_t *header, uint8_t *buff)
+{
+    CRC32_Start(0);
+    CRC32_Accumulate((uint8_t *)&header->generation, SLOT_HEADER_LENGTH - sizeof(uint32_t));
+    CRC32_Accumulate(buff, header->length);
+    return CRC32_Get();
+} // slotCrc32
+
+bool FlashSlotVar::slotValid(slot_header_t *header)
+{
+    return (SLOT_BLANK != header->crc32)
+           && (SLOT_BLANK != header->generation)
+           && (0 != header->length)
+           && (header->length <= _data_length);
+} // slotValid
+
+/**
+ * @brief The valid slot have the newest generation.
+ */
+uint16_t FlashSlotVar::slotNewest()
+{
+    uint16_t newest = SLOT_NONE;
+
+    for (uint16_t slot = 0; slot < _slot_count; ++slot)
+    {
+        if (SLOT_BLANK == _pHeader[slot].crc32)
+        {
+            continue;
+        }
+
+        if ((SLOT_NONE == newest) || (_pHeader[slot].generation > _pHeader[newest].generation))
+        {
+            newest = slot;
+        }
+    }
+
+    return newest;
+} // slotNewest
+
+/**
+ * @brief The slot is not valid, or the oldest slot.
+ */
+uint16_t FlashSlotVar::slotTarget()
+{
+    uint16_t target = 0;
+
+    for (uint16_t slot = 0; slot < _slot_count; ++slot)
+    {
+        if (SLOT_BLANK == _pHeader[slot].crc32)
+        {
+            return slot;
+        }
+
+        if (_pHeader[slot].generation < _pHeader[target].generation)
+        {
+            target = slot;
+        }
+    }
+
+    return target;
+} // slotTarget
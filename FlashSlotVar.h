@@ -0,0 +1,94 @@
+/** @file FlashSlotVar.h
+ *  @brief utility support saving a large, rarely updated variable into
+ *         N fixed slots of a space NAND/NOR memory (A/B double buffer)
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_SLOT_VAR_H
+#define __FLASH_SLOT_VAR_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define FSV_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FSV]", __VA_ARGS__)
+
+/**
+ * Each slot is whole pages: header (crc32, generation, length) + data.
+ * The data is written before the header, so a slot with header have all data.
+ * Mount read only the headers, the newest generation is the current slot and
+ * the next write erase a slot not valid or the oldest slot.
+ */
+class FlashSlotVar
+{
+    typedef enum
+    {
+        SLOT_HEADER_LENGTH = 12,
+        SLOT_NONE = 0xFFFF,
+        SLOT_BLANK = 0xFFFFFFFF
+    } slotType_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t crc32; /* generation + length + data */
+        uint32_t generation;
+        uint32_t length;
+    } slot_header_t;
+
+public:
+    FlashSlotVar(uint32_t start_addr = 0,
+                 size_t memory_size = MEMORY_SIZE_DEFAULT,
+                 uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT,
+                 uint32_t data_length = 1,
+                 uint16_t slot_count = 2);
+    ~FlashSlotVar();
+    void setCallbacks(FlashWearLevellingCallbacks *pCallbacks);
+    bool begin(bool formatOnFail = false);
+    bool format();
+    bool write(uint8_t *buff, uint32_t *length);
+    bool read(uint8_t *buff, uint32_t *length);
+    uint32_t generation();
+
+    template <typename varType>
+    bool write(varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        return write((uint8_t *)data, &length) && (length == sizeof(varType));
+    } // write
+
+    template <typename varType>
+    bool read(varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        return read((uint8_t *)data, &length) && (length == sizeof(varType));
+    } // read
+
+private:
+    const uint32_t _start_addr;
+    const size_t _memory_size;
+    const uint16_t _page_erase_size;
+    const uint32_t _data_length;
+    const uint16_t _slot_count;
+    const uint32_t _slot_size;
+    slot_header_t *_pHeader; /* header of each slot, crc32 is SLOT_BLANK if not valid */
+    uint16_t _current;
+    uint32_t _generation_next;
+    FlashWearLevellingCallbacks *_pCallbacks;
+    bool verifyMemInfo();
+    uint32_t slotAddr(uint16_t slot);
+    uint32_t slotCrc32(slot_header_t *header, uint8_t *buff);
+    bool slotValid(slot_header_t *header);
+    uint16_t slotNewest();
+    uint16_t slotTarget();
+};
+
+#endif
@@ -0,0 +1,432 @@
+#include "FlashTimeLog.h"
+
+static uint32_t ftl_le32(const uint8_t *buff)
+{
+    return buff[0] | ((uint32_t)buff[1] << 8) | ((uint32_t)buff[2] << 16) | ((uint32_t)buff[3] << 24);
+} // ftl_le32
+
+FlashTimeLog::
+    FlashTimeLog(uint32_t start_addr,
+                 size_t memory_size,
+                 uint16_t page_erase_size,
+                 uint16_t data_length) : FlashWearLevellingUtils(start_addr,
+                                                                 memory_size,
+                                                                 page_erase_size,
+                                                                 TIME_LENGTH + data_length),
+                                         _page_cnt(page_erase_size ? (memory_size / page_erase_size) : 0),
+                                         _pSummary(nullptr),
+                                         _pScratch(nullptr),
+                                         _last_time(0)
+{
+    memset(&_aggregate, 0, sizeof(log_aggregate_t));
+    /* The summaries are built by the history */
+    _inPlace_isAllowed = false;
+} // FlashTimeLog
+
+FlashTimeLog::~FlashTimeLog()
+{
+    delete[] _pSummary; /* free memory */
+    delete[] _pScratch; /* free memory */
+} // ~FlashTimeLog
+
+/**
+ * Find the last header and build the summaries of pages, the chain is walked only once
+*/
+bool FlashTimeLog::begin(bool formatOnFail)
+{
+    if (!verifyMemInfo())
+    {
+        FTL_TAG_INFO("[begin] memory info Failed!");
+        return false;
+    }
+
+    if (_pSummary == nullptr)
+    {
+        _pSummary = new (std::nothrow) page_summary_t[_page_cnt];
+        _pScratch = new (std::nothrow) uint8_t[MEMORY_LENGTH_MAX];
+        if ((_pSummary == nullptr) || (_pScratch == nullptr))
+        {
+            FTL_TAG_INFO("[begin] Allocate RAM failed!");
+            delete[] _pSummary;
+            delete[] _pScratch;
+            _pSummary = nullptr;
+            _pScratch = nullptr;
+            return false;
+        }
+    }
+
+    memset(_pSummary, 0, _page_cnt * sizeof(page_summary_t));
+    memset(&_aggregate, 0, sizeof(log_aggregate_t));
+    _last_time = 0;
+    if (!FlashWearLevellingUtils::begin(formatOnFail))
+    {
+        FTL_TAG_INFO("[begin] memory failed!");
+        return false;
+    }
+
+    if (!history(historyVisitor_t(this, &FlashTimeLog::summaryRecord), UINT32_MAX, true))
+    {
+        FTL_TAG_INFO("[begin] history failed!");
+        return false;
+    }
+
+    aggregateUpdate();
+    return true;
+} // begin
+
+/**
+ * Format memory type as factory, all records are removed
+*/
+bool FlashTimeLog::format()
+{
+    if (!FlashWearLevellingUtils::format())
+    {
+        return false;
+    }
+
+    headerDefault();
+    if (_pSummary != nullptr)
+    {
+        memset(_pSummary, 0, _page_cnt * sizeof(page_summary_t));
+    }
+    memset(&_aggregate, 0, sizeof(log_aggregate_t));
+    _last_time = 0;
+    return true;
+} // format
+
+/** Append a record
+ *
+ *  @param time     The timestamp, must not be less than the timestamp of the newest record
+ *  @param buff     Buffer of data to write
+ *  @param length   Size to write in bytes
+ *  @return         True if write is succeed
+ */
+bool FlashTimeLog::append(uint32_t time, uint8_t *buff, uint32_t *length)
+{
+    uint32_t data_length;
+
+    if ((_pScratch == nullptr) || ((*length) > (MEMORY_LENGTH_MAX - TIME_LENGTH)))
+    {
+        FTL_TAG_INFO("[append] begin() is not called or length failed!");
+        return false;
+    }
+
+    if ((_memory_cxt.header.dataLength > 0) && (time < _last_time))
+    {
+        FTL_TAG_INFO("[append] time %u is before %u", time, _last_time);
+        return false;
+    }
+
+    _pScratch[0] = (uint8_t)time;
+    _pScratch[1] = (uint8_t)(time >> 8);
+    _pScratch[2] = (uint8_t)(time >> 16);
+    _pScratch[3] = (uint8_t)(time >> 24);
+    if ((*length) > 0)
+    {
+        memcpy(_pScratch + TIME_LENGTH, buff, *length);
+    }
+
+    data_length = TIME_LENGTH + (*length);
+    if (!write(_pScratch, &data_length))
+    {
+        FTL_TAG_INFO("[append] write failed!");
+        return false;
+    }
+
+    /* The pages erased by the write have no record */
+    summaryErase(_memory_cxt.header.addr, _memory_cxt.header.nextAddr);
+    summaryAdd(_memory_cxt.header.addr, time, buff, *length);
+    _last_time = time;
+    return true;
+} // append
+
+/** Walk the records which timestamp in [t0, t1], from the oldest
+ *
+ *  @param t0       The begin of range
+ *  @param t1       The end of range (inclusive)
+ *  @param visitor  Called for each record, return false to stop
+ *  @return         True if the walk is not stopped by a read error
+ */
+bool FlashTimeLog::findRange(uint32_t t0, uint32_t t1, rangeVisitor_t visitor)
+{
+    prefetch_cxt_t win;
+    memory_cxt_t mem_cxt;
+    uint32_t page, time;
+    bool status_isOK = true;
+
+    if ((_pSummary == nullptr) || (t1 < t0))
+    {
+        FTL_TAG_INFO("[findRange] begin() is not called or range failed!");
+        return false;
+    }
+
+    page = summaryFind(t0);
+    if (_page_cnt == page)
+    {
+        FTL_TAG_INFO("[findRange] No");
+        return true;
+    }
+    FTL_TAG_INFO("[findRange] page %u first addr %u(0x%X)", page, _pSummary[page].firstAddr, _pSummary[page].firstAddr);
+
+    /* Allocate dynamic memory */
+    win.size = HISTORY_PREFETCH_SIZE_DEFAULT;
+    if (win.size > _memory_size)
+    {
+        win.size = _memory_size;
+    }
+    win.pBuffer = scratchAlloc(win.size);
+    if (win.pBuffer == nullptr)
+    {
+        FTL_TAG_INFO("[findRange] Allocate RAM failed!");
+        return false;
+    }
+    win.addr = 0;
+    win.length = 0;
+
+    if (!prefetchRecord(&win, _pSummary[page].firstAddr, &mem_cxt, false))
+    {
+        FTL_TAG_INFO("[findRange] Read record failed!");
+        status_isOK = false;
+    }
+
+    while (status_isOK)
+    {
+        if ((MEMORY_HEADER_TYPE == mem_cxt.header.type) && (mem_cxt.data.length >= TIME_LENGTH))
+        {
+            time = ftl_le32(mem_cxt.data.pBuffer);
+            if (time > t1)
+            {
+                break;
+            }
+
+            if (time >= t0)
+            {
+                /* Lazy checksum, only the record handed to the visitor */
+                if (!verifyData(&mem_cxt))
+                {
+                    FTL_TAG_INFO("[findRange] CRC32 failed!");
+                    status_isOK = false;
+                    break;
+                }
+
+                if (!visitor(time, mem_cxt.data.pBuffer + TIME_LENGTH, mem_cxt.data.length - TIME_LENGTH))
+                {
+                    break;
+                }
+            }
+        }
+
+        /* The newest record is reached */
+        if (mem_cxt.header.addr == _memory_cxt.header.addr)
+        {
+            break;
+        }
+
+        if (!historyNext(&win, &mem_cxt))
+        {
+            FTL_TAG_INFO("[findRange] chain broken!");
+            status_isOK = false;
+        }
+    }
+
+    scratchFree(win.pBuffer); /* free memory */
+
+    return status_isOK;
+} // findRange
+
+/**
+ * Set the function get the value of a record for the aggregates
+*/
+void FlashTimeLog::setAggregate(valueExtractor_t extractor)
+{
+    _extractor = extractor;
+} // setAggregate
+
+/** Get min/max/sum/count of the values of all records stored, O(1)
+ *
+ *  @param agg      The aggregates
+ *  @return         False if there is no value
+ */
+bool FlashTimeLog::aggregate(log_aggregate_t *agg)
+{
+    if (0 == _aggregate.count)
+    {
+        return false;
+    }
+
+    *agg = _aggregate;
+    return true;
+} // aggregate
+
+/**
+ * @brief History visitor, add a record to the summary of its page.
+ */
+bool FlashTimeLog::summaryRecord(const memory_cxt_t *mem)
+{
+    if ((MEMORY_HEADER_TYPE == mem->header.type) && (mem->data.length >= TIME_LENGTH))
+    {
+        _last_time = ftl_le32(mem->data.pBuffer);
+        summaryAdd(mem->header.addr, _last_time, mem->data.pBuffer + TIME_LENGTH, mem->data.length - TIME_LENGTH);
+    }
+
+    return true;
+} // summaryRecord
+
+void FlashTimeLog::summaryAdd(uint32_t addr, uint32_t time, const uint8_t *buff, uint32_t length)
+{
+    page_summary_t *summary = &_pSummary[(addr - _start_addr) / _page_erase_size];
+    float value;
+
+    if (0 == summary->count)
+    {
+        summary->firstTime = time;
+        summary->firstAddr = addr;
+        memset(&summary->aggregate, 0, sizeof(log_aggregate_t));
+    }
+    summary->lastTime = time;
+    ++summary->count;
+
+    if (_extractor && _extractor(buff, length, &value))
+    {
+        aggregateAdd(&summary->aggregate, value);
+        aggregateAdd(&_aggregate, value);
+    }
+} // summaryAdd
+
+/**
+ * @brief Clear the summaries of the pages erased by the record at addr,
+ *        the same rule as saveHeader() and eraseData().
+ */
+void FlashTimeLog::summaryErase(uint32_t addr, uint32_t next_addr)
+{
+    page_summary_t *summary;
+    uint32_t page_addr;
+    bool aggregate_isChanged = false;
+
+    /* Reset address to _start_addr erase the first page */
+    if ((_start_addr == addr) && (_pSummary[0].count > 0))
+    {
+        _pSummary[0].count = 0;
+        aggregate_isChanged = (_pSummary[0].aggregate.count > 0);
+    }
+
+    page_addr = _start_addr + ((addr - _start_addr) / _page_erase_size + 1) * _page_erase_size;
+    while ((page_addr <= next_addr) && (page_addr < (_start_addr + _memory_size)))
+    {
+        summary = &_pSummary[(page_addr - _start_addr) / _page_erase_size];
+        if ((summary->count > 0) && (summary->aggregate.count > 0))
+        {
+            aggregate_isChanged = true;
+        }
+        summary->count = 0;
+        page_addr += _page_erase_size;
+    }
+
+    /* min/max of the records erased can not be removed, merge the pages again */
+    if (aggregate_isChanged)
+    {
+        aggregateUpdate();
+    }
+} // summaryErase
+
+/**
+ * @brief The page index of the i-th page sorted by time, the oldest page is after
+ *        the page of the newest record.
+ */
+uint32_t FlashTimeLog::summaryPage(uint32_t i)
+{
+    return ((_memory_cxt.header.addr - _start_addr) / _page_erase_size + 1 + i) % _page_cnt;
+} // summaryPage
+
+/**
+ * @brief Binary search the oldest page have a record not before t0.
+ * @return The page index, _page_cnt if not found.
+ */
+uint32_t FlashTimeLog::summaryFind(uint32_t t0)
+{
+    uint32_t lo, hi, mid, i;
+
+    if (0 == _memory_cxt.header.dataLength)
+    {
+        return _page_cnt;
+    }
+
+    /* The key of i is the last time of the first page have record from i */
+    lo = 0;
+    hi = _page_cnt;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        for (i = mid; (i < hi) && (0 == _pSummary[summaryPage(i)].count); ++i)
+        {
+        }
+
+        if ((i < hi) && (_pSummary[summaryPage(i)].lastTime < t0))
+        {
+            lo = i + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    /* The first page have record from lo */
+    for (i = lo; i < _page_cnt; ++i)
+    {
+        if (_pSummary[summaryPage(i)].count > 0)
+        {
+            return summaryPage(i);
+        }
+    }
+
+    return _page_cnt;
+} // summaryFind
+
+void FlashTimeLog::aggregateAdd(log_aggregate_t *agg, float value)
+{
+    if ((0 == agg->count) || (value < agg->min))
+    {
+        agg->min = value;
+    }
+    if ((0 == agg->count) || (value > agg->max))
+    {
+        agg->max = value;
+    }
+    agg->sum += value;
+    ++agg->count;
+} // aggregateAdd
+
+void FlashTimeLog::aggregateMerge(log_aggregate_t *agg, const log_aggregate_t *page)
+{
+    if (0 == page->count)
+    {
+        return;
+    }
+
+    if ((0 == agg->count) || (page->min < agg->min))
+    {
+        agg->min = page->min;
+    }
+    if ((0 == agg->count) || (page->max > agg->max))
+    {
+        agg->max = page->max;
+    }
+    agg->sum += page->sum;
+    agg->count += page->count;
+} // aggregateMerge
+
+/**
+ * @brief Merge the aggregates of all pages have record.
+ */
+void FlashTimeLog::aggregateUpdate()
+{
+    memset(&_aggregate, 0, sizeof(log_aggregate_t));
+    for (uint32_t page = 0; page < _page_cnt; ++page)
+    {
+        if (_pSummary[page].count > 0)
+        {
+            aggregateMerge(&_aggregate, &_pSummary[page].aggregate);
+        }
+    }
+} // aggregateUpdate
@@ -0,0 +1,106 @@
+/** @file FlashTimeLog.h
+ *  @brief utility support an append only log of timestamped records
+ *         into a space NAND/NOR memory, a range of time is found by
+ *         binary search of the per-page summaries
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_TIME_LOG_H
+#define __FLASH_TIME_LOG_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define FTL_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FTL]", __VA_ARGS__)
+
+typedef struct
+{
+    float min;
+    float max;
+    double sum;
+    uint32_t count;
+} log_aggregate_t;
+
+/**
+ * The record data of time log: timestamp (4-byte) + data.
+ * The timestamps must not decrease, so the pages are sorted by time from the
+ * oldest page (after the page of the newest record) to the newest page.
+ */
+class FlashTimeLog : protected FlashWearLevellingUtils
+{
+    typedef enum
+    {
+        TIME_LENGTH = 4
+    } timeType_t;
+
+    /* The records which header start in a page */
+    typedef struct
+    {
+        uint32_t firstTime;
+        uint32_t lastTime;
+        uint32_t firstAddr;
+        uint16_t count;
+        log_aggregate_t aggregate;
+    } page_summary_t;
+
+public:
+    /* Visitor return false to stop walking the records */
+    typedef mbed::Callback<bool(uint32_t time, const uint8_t *buff, uint32_t length)> rangeVisitor_t;
+    /* Return false if the record have not a value */
+    typedef mbed::Callback<bool(const uint8_t *buff, uint32_t length, float *value)> valueExtractor_t;
+
+    FlashTimeLog(uint32_t start_addr = 0,
+                 size_t memory_size = MEMORY_SIZE_DEFAULT,
+                 uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT,
+                 uint16_t data_length = 4);
+    ~FlashTimeLog();
+
+    using FlashWearLevellingUtils::setCallbacks;
+    using FlashWearLevellingUtils::stats;
+    using FlashWearLevellingUtils::resetStats;
+    using FlashWearLevellingUtils::writeAmplification;
+    using FlashWearLevellingUtils::lifetime;
+    using FlashWearLevellingUtils::info;
+    bool begin(bool formatOnFail = false);
+    bool format();
+    bool append(uint32_t time, uint8_t *buff, uint32_t *length);
+    bool findRange(uint32_t t0, uint32_t t1, rangeVisitor_t visitor);
+    /* Set before begin(), the aggregates are built with the summaries of pages */
+    void setAggregate(valueExtractor_t extractor);
+    bool aggregate(log_aggregate_t *agg);
+
+    template <typename varType>
+    bool append(uint32_t time, varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        return append(time, (uint8_t *)data, &length) && (length == sizeof(varType));
+    } // append
+
+private:
+    const uint32_t _page_cnt;
+    page_summary_t *_pSummary;
+    uint8_t *_pScratch;
+    uint32_t _last_time;
+    valueExtractor_t _extractor;
+    log_aggregate_t _aggregate; /* all pages */
+    bool summaryRecord(const memory_cxt_t *mem);
+    void summaryAdd(uint32_t addr, uint32_t time, const uint8_t *buff, uint32_t length);
+    void aggregateAdd(log_aggregate_t *agg, float value);
+    void aggregateMerge(log_aggregate_t *agg, const log_aggregate_t *page);
+    void aggregateUpdate();
+    void summaryErase(uint32_t addr, uint32_t next_addr);
+    uint32_t summaryPage(uint32_t i);
+    uint32_t summaryFind(uint32_t t0);
+};
+
+#endif
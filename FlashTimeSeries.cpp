@@ -0,0 +1,481 @@
+#include "FlashTimeSeries.h"
+
+#define TS_BLOCK_HEADER_LENGTH 11U /* count (2) + value type (1) + time (4) + value (4) */
+#define TS_SAMPLE_BITS_MAX 80U     /* timestamp (4 + 32) + float (2 + 5 + 5 + 32) */
+#define TS_WINDOW_NONE 0xFFU
+
+/**
+ * @brief Small signed number to small unsigned number.
+ */
+static uint32_t fts_zigzag(uint32_t value)
+{
+    return (value << 1) ^ (uint32_t)((int32_t)value >> 31);
+} // fts_zigzag
+
+static uint32_t fts_unzigzag(uint32_t value)
+{
+    return (value >> 1) ^ (0U - (value & 1U));
+} // fts_unzigzag
+
+static uint32_t fts_le32(const uint8_t *buff)
+{
+    return buff[0] | ((uint32_t)buff[1] << 8) | ((uint32_t)buff[2] << 16) | ((uint32_t)buff[3] << 24);
+} // fts_le32
+
+static void fts_put_le32(uint8_t *buff, uint32_t value)
+{
+    buff[0] = (uint8_t)value;
+    buff[1] = (uint8_t)(value >> 8);
+    buff[2] = (uint8_t)(value >> 16);
+    buff[3] = (uint8_t)(value >> 24);
+} // fts_put_le32
+
+FlashTimeSeriesIterator::
+    FlashTimeSeriesIterator(const uint8_t *block, uint32_t length) : _pBlock(block),
+                                                                     _bit_length(length * 8U),
+                                                                     _bit_pos(TS_BLOCK_HEADER_LENGTH * 8U),
+                                                                     _count(0),
+                                                                     _index(0),
+                                                                     _value_type(TS_VALUE_FLOAT),
+                                                                     _prev_time(0),
+                                                                     _prev_delta(0),
+                                                                     _prev_value(0),
+                                                                     _prev_lead(TS_WINDOW_NONE),
+                                                                     _prev_trail(0)
+{
+    /* A broken block have not sample */
+    if ((length >= TS_BLOCK_HEADER_LENGTH) && (block[2] <= TS_VALUE_INT32))
+    {
+        _count = block[0] | ((uint16_t)block[1] << 8);
+        _value_type = block[2];
+    }
+} // FlashTimeSeriesIterator
+
+/** Decode the next sample of block
+ *
+ *  @param sample   The sample decoded
+ *  @return         False at the end of block or the bit stream is broken
+ */
+bool FlashTimeSeriesIterator::next(ts_sample_t *sample)
+{
+    uint32_t dod, value;
+
+    if (_index >= _count)
+    {
+        return false;
+    }
+
+    if (0 == _index)
+    {
+        _prev_time = fts_le32(_pBlock + 3);
+        _prev_value = fts_le32(_pBlock + 7);
+    }
+    else
+    {
+        if (!getBucket(&dod))
+        {
+            return false;
+        }
+        _prev_delta += fts_unzigzag(dod);
+        _prev_time += _prev_delta;
+
+        if (TS_VALUE_INT32 == _value_type)
+        {
+            if (!getBucket(&value))
+            {
+                return false;
+            }
+            _prev_value += fts_unzigzag(value);
+        }
+        else
+        {
+            if (!getXor(&value))
+            {
+                return false;
+            }
+            _prev_value ^= value;
+        }
+    }
+
+    sample->time = _prev_time;
+    memcpy(&sample->value, &_prev_value, sizeof(uint32_t));
+    ++_index;
+    return true;
+} // next
+
+bool FlashTimeSeriesIterator::getBits(uint8_t bits, uint32_t *value)
+{
+    if ((_bit_length - _bit_pos) < bits)
+    {
+        return false;
+    }
+
+    *value = 0;
+    while (bits-- > 0)
+    {
+        *value = (*value << 1) | ((_pBlock[_bit_pos / 8U] >> (7U - (_bit_pos % 8U))) & 1U);
+        ++_bit_pos;
+    }
+    return true;
+} // getBits
+
+bool FlashTimeSeriesIterator::getBucket(uint32_t *value)
+{
+    static const uint8_t bucket_bits[] = {7, 9, 12, 32};
+    uint32_t bit;
+    uint8_t prefix;
+
+    /* The number of '1' before '0' select the bucket, '1111' have not '0' */
+    for (prefix = 0; prefix < 4; ++prefix)
+    {
+        if (!getBits(1, &bit))
+        {
+            return false;
+        }
+        if (0 == bit)
+        {
+            break;
+        }
+    }
+
+    if (0 == prefix)
+    {
+        *value = 0;
+        return true;
+    }
+
+    return getBits(bucket_bits[prefix - 1], value);
+} // getBucket
+
+bool FlashTimeSeriesIterator::getXor(uint32_t *value)
+{
+    uint32_t control, lead, length;
+
+    if (!getBits(1, &control))
+    {
+        return false;
+    }
+
+    if (0 == control)
+    {
+        *value = 0;
+        return true;
+    }
+
+    if (!getBits(1, &control))
+    {
+        return false;
+    }
+
+    if (control)
+    {
+        /* New window */
+        if (!getBits(5, &lead) || !getBits(5, &length) || ((lead + length + 1U) > 32U))
+        {
+            return false;
+        }
+        _prev_lead = lead;
+        _prev_trail = 32U - lead - (length + 1U);
+    }
+    else if (TS_WINDOW_NONE == _prev_lead)
+    {
+        return false;
+    }
+
+    if (!getBits(32U - _prev_lead - _prev_trail, value))
+    {
+        return false;
+    }
+    *value <<= _prev_trail;
+    return true;
+} // getXor
+
+FlashTimeSeries::
+    FlashTimeSeries(uint32_t start_addr,
+                    size_t memory_size,
+                    uint16_t page_erase_size,
+                    ts_value_t value_type) : FlashWearLevellingUtils(start_addr,
+                                                                     memory_size,
+                                                                     page_erase_size,
+                                                                     MEMORY_LENGTH_MAX),
+                                             _value_type(value_type),
+                                             _pBlock(nullptr),
+                                             _bit_pos(0),
+                                             _block_cnt(0)
+{
+    /* The samples are read by the history */
+    _inPlace_isAllowed = false;
+} // FlashTimeSeries
+
+FlashTimeSeries::~FlashTimeSeries()
+{
+    delete[] _pBlock; /* free memory */
+} // ~FlashTimeSeries
+
+/**
+ * Find the last header, the samples buffered are dropped
+*/
+bool FlashTimeSeries::begin(bool formatOnFail)
+{
+    if (_pBlock == nullptr)
+    {
+        _pBlock = new (std::nothrow) uint8_t[MEMORY_LENGTH_MAX];
+        if (_pBlock == nullptr)
+        {
+            FTS_TAG_INFO("[begin] Allocate RAM failed!");
+            return false;
+        }
+    }
+
+    _block_cnt = 0;
+    return FlashWearLevellingUtils::begin(formatOnFail);
+} // begin
+
+/**
+ * Format memory type as factory, all samples are removed
+*/
+bool FlashTimeSeries::format()
+{
+    if (!FlashWearLevellingUtils::format())
+    {
+        return false;
+    }
+
+    headerDefault();
+    _block_cnt = 0;
+    return true;
+} // format
+
+/** Append a sample to the block buffered, the block is written when it is full
+ *
+ *  @param sample   The sample, the timestamp is normally increasing
+ *  @return         True if append is succeed
+ */
+bool FlashTimeSeries::append(const ts_sample_t *sample)
+{
+    uint32_t value;
+
+    if (_pBlock == nullptr)
+    {
+        FTS_TAG_INFO("[append] begin() is not called!");
+        return false;
+    }
+
+    /* The worst sample must fit the block */
+    if ((_block_cnt > 0) && ((_bit_pos + TS_SAMPLE_BITS_MAX) > (MEMORY_LENGTH_MAX * 8U)))
+    {
+        if (!flush())
+        {
+            return false;
+        }
+    }
+
+    memcpy(&value, &sample->value, sizeof(uint32_t));
+    if (0 == _block_cnt)
+    {
+        memset(_pBlock, 0, MEMORY_LENGTH_MAX);
+        _pBlock[2] = _value_type;
+        fts_put_le32(_pBlock + 3, sample->time);
+        fts_put_le32(_pBlock + 7, value);
+        _bit_pos = TS_BLOCK_HEADER_LENGTH * 8U;
+        _prev_delta = 0;
+        _prev_lead = TS_WINDOW_NONE;
+        _prev_trail = 0;
+    }
+    else
+    {
+        uint32_t delta = sample->time - _prev_time;
+        putBucket(fts_zigzag(delta - _prev_delta));
+        _prev_delta = delta;
+
+        if (TS_VALUE_INT32 == _value_type)
+        {
+            putBucket(fts_zigzag(value - _prev_value));
+        }
+        else
+        {
+            putXor(value ^ _prev_value);
+        }
+    }
+
+    _prev_time = sample->time;
+    _prev_value = value;
+    ++_block_cnt;
+    _pBlock[0] = (uint8_t)_block_cnt;
+    _pBlock[1] = (uint8_t)(_block_cnt >> 8);
+    return true;
+} // append
+
+/** Write the block buffered as one record
+ *
+ *  @return         True if write is succeed or nothing is buffered
+ */
+bool FlashTimeSeries::flush()
+{
+    uint32_t length;
+
+    if (0 == _block_cnt)
+    {
+        return true;
+    }
+
+    length = (_bit_pos + 7U) / 8U;
+    FTS_TAG_INFO("[flush] %u samples, %u byte", _block_cnt, length);
+    if (!write(_pBlock, &length))
+    {
+        FTS_TAG_INFO("[flush] write failed!");
+        return false;
+    }
+
+    _block_cnt = 0;
+    return true;
+} // flush
+
+/**
+ * Return the number of samples are not written
+*/
+uint16_t FlashTimeSeries::buffered()
+{
+    return _block_cnt;
+} // buffered
+
+/** Walk the samples from the oldest to the newest, the samples buffered are the last
+ *
+ *  @param visitor      Called for each sample, return false to stop
+ *  @param blockCount   Maximum number of the newest blocks written to visit
+ *  @return             True if the walk is not stopped by a read error
+ */
+bool FlashTimeSeries::samples(sampleVisitor_t visitor, uint32_t blockCount)
+{
+    if (_pBlock == nullptr)
+    {
+        FTS_TAG_INFO("[samples] begin() is not called!");
+        return false;
+    }
+
+    _visitor = visitor;
+    _visit_isStop = false;
+    _visit_isOK = true;
+
+    if (!history(historyVisitor_t(this, &FlashTimeSeries::decodeRecord), blockCount, true) || !_visit_isOK)
+    {
+        FTS_TAG_INFO("[samples] history failed!");
+        return false;
+    }
+
+    if (!_visit_isStop && (_block_cnt > 0))
+    {
+        return decodeBlock(_pBlock, (_bit_pos + 7U) / 8U);
+    }
+
+    return true;
+} // samples
+
+void FlashTimeSeries::putBits(uint32_t value, uint8_t bits)
+{
+    /* The block is zero at start, only '1' is set */
+    while (bits-- > 0)
+    {
+        if ((value >> bits) & 1U)
+        {
+            _pBlock[_bit_pos / 8U] |= (uint8_t)(0x80U >> (_bit_pos % 8U));
+        }
+        ++_bit_pos;
+    }
+} // putBits
+
+void FlashTimeSeries::putBucket(uint32_t value)
+{
+    if (0 == value)
+    {
+        putBits(0x0, 1);
+    }
+    else if (value < (1U << 7))
+    {
+        putBits(0x2, 2);
+        putBits(value, 7);
+    }
+    else if (value < (1U << 9))
+    {
+        putBits(0x6, 3);
+        putBits(value, 9);
+    }
+    else if (value < (1U << 12))
+    {
+        putBits(0xE, 4);
+        putBits(value, 12);
+    }
+    else
+    {
+        putBits(0xF, 4);
+        putBits(value, 32);
+    }
+} // putBucket
+
+void FlashTimeSeries::putXor(uint32_t value)
+{
+    uint8_t lead, trail;
+
+    if (0 == value)
+    {
+        putBits(0x0, 1);
+        return;
+    }
+
+    lead = __builtin_clz(value);
+    trail = __builtin_ctz(value);
+    if ((TS_WINDOW_NONE != _prev_lead) && (lead >= _prev_lead) && (trail >= _prev_trail))
+    {
+        /* The meaningful bits are in previous window */
+        putBits(0x2, 2);
+        putBits(value >> _prev_trail, 32U - _prev_lead - _prev_trail);
+        return;
+    }
+
+    putBits(0x3, 2);
+    putBits(lead, 5);
+    putBits(32U - lead - trail - 1U, 5);
+    putBits(value >> trail, 32U - lead - trail);
+    _prev_lead = lead;
+    _prev_trail = trail;
+} // putXor
+
+/**
+ * @brief Hand all samples of a block to the visitor of samples().
+ */
+bool FlashTimeSeries::decodeBlock(const uint8_t *block, uint32_t length)
+{
+    FlashTimeSeriesIterator it(block, length);
+    ts_sample_t sample;
+
+    for (uint16_t i = 0; i < it.count(); ++i)
+    {
+        if (!it.next(&sample))
+        {
+            FTS_TAG_INFO("[decodeBlock] block broken!");
+            _visit_isOK = false;
+            return false;
+        }
+
+        if (!_visitor(&sample))
+        {
+            _visit_isStop = true;
+            return false;
+        }
+    }
+
+    return true;
+} // decodeBlock
+
+/**
+ * @brief History visitor, a record is a block.
+ */
+bool FlashTimeSeries::decodeRecord(const memory_cxt_t *mem)
+{
+    if (MEMORY_HEADER_TYPE != mem->header.type)
+    {
+        return true;
+    }
+
+    return decodeBlock(mem->data.pBuffer, mem->data.length);
+} // decodeRecord
@@ -0,0 +1,128 @@
+/** @file FlashTimeSeries.h
+ *  @brief utility support saving the samples of a sensor (timestamp + value)
+ *         into a space NAND/NOR memory, the samples are buffered and stored
+ *         by blocks encoded with delta-of-delta timestamp and XOR float
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_TIME_SERIES_H
+#define __FLASH_TIME_SERIES_H
+
+#include "FlashWearLevellingUtils.h"
+
+#define FTS_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FTS]", __VA_ARGS__)
+
+typedef enum
+{
+    TS_VALUE_FLOAT = 0, /* XOR with previous value */
+    TS_VALUE_INT32 = 1  /* delta with previous value */
+} ts_value_t;
+
+typedef struct
+{
+    uint32_t time;
+    union
+    {
+        float f;
+        int32_t i;
+    } value;
+} ts_sample_t;
+
+/**
+ * The record data of a block: count (2-byte) + value type (1-byte) + first sample (8-byte)
+ * + bit stream of the next samples, MSB first:
+ *  - timestamp: delta-of-delta zigzag, '0' | '10' 7-bit | '110' 9-bit | '1110' 12-bit | '1111' 32-bit
+ *  - TS_VALUE_INT32: delta zigzag, same as timestamp
+ *  - TS_VALUE_FLOAT: XOR with previous, '0' | '10' bits in previous window
+ *                    | '11' leading (5-bit) + length - 1 (5-bit) + bits
+ */
+class FlashTimeSeriesIterator
+{
+public:
+    FlashTimeSeriesIterator(const uint8_t *block, uint32_t length);
+    /* False at the end of block or the block is broken */
+    bool next(ts_sample_t *sample);
+    uint16_t count() const
+    {
+        return _count;
+    } // count
+
+private:
+    const uint8_t *_pBlock;
+    uint32_t _bit_length;
+    uint32_t _bit_pos;
+    uint16_t _count;
+    uint16_t _index;
+    uint8_t _value_type;
+    uint32_t _prev_time;
+    uint32_t _prev_delta;
+    uint32_t _prev_value;
+    uint8_t _prev_lead;
+    uint8_t _prev_trail;
+    bool getBits(uint8_t bits, uint32_t *value);
+    bool getBucket(uint32_t *value);
+    bool getXor(uint32_t *value);
+};
+
+/**
+ * Example:
+ *  FlashTimeSeries temperature(0, 16384, 4096, TS_VALUE_FLOAT);
+ *  temperature.append(&sample);
+ *  temperature.flush(); // before power off, the samples buffered in RAM are lost
+ */
+class FlashTimeSeries : protected FlashWearLevellingUtils
+{
+public:
+    /* Visitor return false to stop walking the samples */
+    typedef mbed::Callback<bool(const ts_sample_t *)> sampleVisitor_t;
+
+    FlashTimeSeries(uint32_t start_addr = 0,
+                    size_t memory_size = MEMORY_SIZE_DEFAULT,
+                    uint16_t page_erase_size = PAGE_ERASE_SIZE_DEFAULT,
+                    ts_value_t value_type = TS_VALUE_FLOAT);
+    ~FlashTimeSeries();
+
+    using FlashWearLevellingUtils::setCallbacks;
+    using FlashWearLevellingUtils::stats;
+    using FlashWearLevellingUtils::resetStats;
+    using FlashWearLevellingUtils::writeAmplification;
+    using FlashWearLevellingUtils::lifetime;
+    bool begin(bool formatOnFail = false);
+    bool format();
+    bool append(const ts_sample_t *sample);
+    bool flush();
+    uint16_t buffered();
+    bool samples(sampleVisitor_t visitor, uint32_t blockCount = UINT32_MAX);
+
+private:
+    const uint8_t _value_type;
+    uint8_t *_pBlock;
+    uint32_t _bit_pos;
+    uint16_t _block_cnt;
+    uint32_t _prev_time;
+    uint32_t _prev_delta;
+    uint32_t _prev_value;
+    uint8_t _prev_lead;
+    uint8_t _prev_trail;
+    sampleVisitor_t _visitor;
+    bool _visit_isStop;
+    bool _visit_isOK;
+    void putBits(uint32_t value, uint8_t bits);
+    void putBucket(uint32_t value);
+    void putXor(uint32_t value);
+    bool decodeBlock(const uint8_t *block, uint32_t length);
+    bool decodeRecord(const memory_cxt_t *mem);
+};
+
+#endif
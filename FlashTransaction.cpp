@@ -0,0 +1,325 @@
+#include "FlashTransaction.h"
+
+FlashTransaction::FlashTransaction(FlashWearLevellingUtils *journal) : _pJournal(journal),
+                                                                      _participant_cnt(0),
+                                                                      _id(0),
+                                                                      _txn_isOpen(false)
+{
+} // FlashTransaction
+
+/**
+ * Add an instance can be staged, all instances must be attached before recover()
+*/
+bool FlashTransaction::attach(FlashWearLevellingUtils *region)
+{
+    if ((region == nullptr) || (region == _pJournal) || (_participant_cnt >= TXN_PARTICIPANT_MAX))
+    {
+        FTX_TAG_INFO("[attach] failed!");
+        return false;
+    }
+
+    if (findParticipant(region) == nullptr)
+    {
+        _participant[_participant_cnt].pRegion = region;
+        _participant[_participant_cnt].isStaged = false;
+        ++_participant_cnt;
+    }
+
+    return true;
+} // attach
+
+/**
+ * Roll back the transaction was not committed before power lost,
+ * called once at mount after begin() of the journal and all instances
+*/
+bool FlashTransaction::recover()
+{
+    txn_record_t record;
+    uint32_t length = sizeof(txn_record_t);
+
+    _txn_isOpen = false;
+    if (0 == _pJournal->info().header.dataLength)
+    {
+        _id = 0;
+        return true;
+    }
+
+    if (!_pJournal->read((uint8_t *)&record, &length) || (length != sizeof(txn_record_t)))
+    {
+        FTX_TAG_INFO("[recover] journal failed!");
+        return false;
+    }
+
+    _id = record.id;
+    if (TXN_STATE_BEGIN != record.state)
+    {
+        return true;
+    }
+
+    FTX_TAG_INFO("[recover] roll back %u", _id);
+    for (uint8_t i = 0; i < _participant_cnt; ++i)
+    {
+        if (!rollback(_participant[i].pRegion))
+        {
+            return false;
+        }
+    }
+
+    return journal(TXN_STATE_ABORT);
+} // recover
+
+/**
+ * Open a transaction, the journal record the begin
+*/
+bool FlashTransaction::beginTxn()
+{
+    if (_txn_isOpen)
+    {
+        FTX_TAG_INFO("[beginTxn] a transaction is opened!");
+        return false;
+    }
+
+    ++_id;
+    if (!journal(TXN_STATE_BEGIN))
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _participant_cnt; ++i)
+    {
+        _participant[i].isStaged = false;
+    }
+    _txn_isOpen = true;
+    return true;
+} // beginTxn
+
+/** Write an intent record, read() of the instance return the previous data until commit()
+ *
+ *  @param region   The instance attached
+ *  @param buff     Buffer of data to write
+ *  @param length   Size to write in bytes, (MEMORY_LENGTH_MAX - 4) at most
+ *  @return         True if write is succeed
+ */
+bool FlashTransaction::stage(FlashWearLevellingUtils *region, uint8_t *buff, uint32_t *length)
+{
+    participant_t *participant = findParticipant(region);
+    memory_cxt_t w_memory;
+    bool status_isOK;
+
+    /* The roll back walk the history, not available in-place mode */
+    if (!_txn_isOpen || (participant == nullptr) || participant->isStaged || region->_inPlace_isEnable)
+    {
+        FTX_TAG_INFO("[stage] no transaction or instance failed!");
+        return false;
+    }
+
+    if ((0 == (*length)) || ((*length) > (FlashWearLevellingUtils::MEMORY_LENGTH_MAX - FlashWearLevellingUtils::MEMORY_TXN_ID_LENGTH)))
+    {
+        FTX_TAG_INFO("[stage] length failed!");
+        return false;
+    }
+
+    uint8_t *ptr_data = FlashWearLevellingUtils::scratchAlloc(FlashWearLevellingUtils::MEMORY_LENGTH_MAX);
+    if (ptr_data == nullptr)
+    {
+        FTX_TAG_INFO("[stage] Allocate RAM failed!");
+        return false;
+    }
+
+    memcpy(ptr_data, &_id, FlashWearLevellingUtils::MEMORY_TXN_ID_LENGTH);
+    memcpy(ptr_data + FlashWearLevellingUtils::MEMORY_TXN_ID_LENGTH, buff, *length);
+
+    w_memory = region->_memory_cxt;
+    w_memory.data.pBuffer = ptr_data;
+    w_memory.data.length = FlashWearLevellingUtils::MEMORY_TXN_ID_LENGTH + (*length);
+    w_memory.header.type = FlashWearLevellingUtils::MEMORY_HEADER_INTENT_TYPE;
+    status_isOK = region->verifyMemInfo() && region->saveData(&w_memory);
+    FlashWearLevellingUtils::scratchFree(ptr_data); /* free memory */
+    if (status_isOK)
+    {
+        region->_stats.payloadBytes += *length;
+    }
+
+    if (!status_isOK)
+    {
+        FTX_TAG_INFO("[stage] write failed!");
+        return false;
+    }
+
+    /* Only the physical tail, the committed record is not changed */
+    region->_memory_cxt = w_memory;
+    participant->staged = w_memory;
+    participant->isStaged = true;
+    return true;
+} // stage
+
+/**
+ * Publish all intent records by one journal record
+*/
+bool FlashTransaction::commit()
+{
+    if (!_txn_isOpen || !journal(TXN_STATE_COMMIT))
+    {
+        FTX_TAG_INFO("[commit] failed!");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _participant_cnt; ++i)
+    {
+        if (_participant[i].isStaged)
+        {
+            _participant[i].pRegion->_commit_cxt = _participant[i].staged;
+            _participant[i].isStaged = false;
+        }
+    }
+
+    _txn_isOpen = false;
+    return true;
+} // commit
+
+/**
+ * Roll back the intent records of the transaction opened
+*/
+bool FlashTransaction::abort()
+{
+    if (!_txn_isOpen)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _participant_cnt; ++i)
+    {
+        if (_participant[i].isStaged && !rollback(_participant[i].pRegion))
+        {
+            return false;
+        }
+        _participant[i].isStaged = false;
+    }
+
+    if (!journal(TXN_STATE_ABORT))
+    {
+        return false;
+    }
+
+    _txn_isOpen = false;
+    return true;
+} // abort
+
+/**
+ * @brief Write a journal record of the current transaction.
+ */
+bool FlashTransaction::journal(uint8_t state)
+{
+    txn_record_t record;
+    uint32_t length = sizeof(txn_record_t);
+
+    record.id = _id;
+    record.state = state;
+    if (!_pJournal->write((uint8_t *)&record, &length))
+    {
+        FTX_TAG_INFO("[journal] write failed!");
+        return false;
+    }
+
+    return true;
+} // journal
+
+FlashTransaction::participant_t *FlashTransaction::findParticipant(FlashWearLevellingUtils *region)
+{
+    for (uint8_t i = 0; i < _participant_cnt; ++i)
+    {
+        if (_participant[i].pRegion == region)
+        {
+            return &_participant[i];
+        }
+    }
+
+    return nullptr;
+} // findParticipant
+
+/**
+ * @brief Write again the newest record before the intent records of the current
+ *        transaction, the instance is formatted if there is no record before.
+ */
+bool FlashTransaction::rollback(FlashWearLevellingUtils *region)
+{
+    memory_cxt_t w_memory;
+    bool status_isOK = true;
+
+    _pFound = FlashWearLevellingUtils::scratchAlloc(FlashWearLevellingUtils::MEMORY_LENGTH_MAX);
+    if (_pFound == nullptr)
+    {
+        FTX_TAG_INFO("[rollback] Allocate RAM failed!");
+        return false;
+    }
+
+    _skip_cnt = 0;
+    _isFound = false;
+    if (!region->history(FlashWearLevellingUtils::historyVisitor_t(this, &FlashTransaction::findCommitted)))
+    {
+        FTX_TAG_INFO("[rollback] history failed!");
+        status_isOK = false;
+    }
+    else if (0 == _skip_cnt)
+    {
+        /* The newest record is not of the transaction */
+    }
+    else if (_isFound)
+    {
+        w_memory = region->_memory_cxt;
+        w_memory.data.pBuffer = _pFound;
+        w_memory.data.length = _found_length;
+        w_memory.header.type = _found_type;
+        status_isOK = region->saveData(&w_memory);
+        if (status_isOK)
+        {
+            region->_memory_cxt = w_memory;
+            region->_commit_cxt = w_memory;
+        }
+    }
+    else
+    {
+        status_isOK = region->format();
+        if (status_isOK)
+        {
+            region->headerDefault();
+        }
+    }
+
+    FlashWearLevellingUtils::scratchFree(_pFound); /* free memory */
+    _pFound = nullptr;
+    FTX_TAG_INFO("[rollback] skip %u, found %u", _skip_cnt, _isFound);
+    return status_isOK;
+} // rollback
+
+/**
+ * @brief History visitor, skip the intent records of the current transaction
+ *        and copy the next record.
+ */
+bool FlashTransaction::findCommitted(const memory_cxt_t *mem)
+{
+    uint32_t id;
+
+    if ((FlashWearLevellingUtils::MEMORY_HEADER_INTENT_TYPE == mem->header.type)
+        && (mem->data.length >= FlashWearLevellingUtils::MEMORY_TXN_ID_LENGTH))
+    {
+        memcpy(&id, mem->data.pBuffer, FlashWearLevellingUtils::MEMORY_TXN_ID_LENGTH);
+        if (id == _id)
+        {
+            ++_skip_cnt;
+            return true;
+        }
+    }
+
+    /* The newest record is not of the transaction, nothing to roll back */
+    if (0 == _skip_cnt)
+    {
+        return false;
+    }
+
+    memcpy(_pFound, mem->data.pBuffer, mem->data.length);
+    _found_length = mem->data.length;
+    _found_type = mem->header.type;
+    _isFound = true;
+    return false;
+} // findCommitted
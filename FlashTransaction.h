@@ -0,0 +1,101 @@
+/** @file FlashTransaction.h
+ *  @brief utility support changing the variables of many
+ *         FlashWearLevellingUtils instances together
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_TRANSACTION_H
+#define __FLASH_TRANSACTION_H
+
+#include "FlashWearLevellingUtils.h"
+
+#ifndef TXN_PARTICIPANT_MAX
+#define TXN_PARTICIPANT_MAX 8U
+#endif
+
+#define FTX_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FTX]", __VA_ARGS__)
+
+/**
+ * A transaction write an intent record (transaction id + data) into each
+ * instance staged, then a commit record into the journal instance.
+ * The journal record is transaction id (4-byte) + state (1-byte).
+ * If the newest journal record is a begin at mount, the intent records of
+ * that transaction are rolled back by writing again the previous record.
+ *
+ * Example:
+ *  FlashTransaction txn(&journal);
+ *  txn.attach(&gain);
+ *  txn.attach(&offset);
+ *  txn.recover(); // after begin() of all instances
+ *  txn.beginTxn();
+ *  txn.stage(&gain, &g);
+ *  txn.stage(&offset, &o);
+ *  txn.commit();
+ */
+class FlashTransaction
+{
+    typedef enum
+    {
+        TXN_STATE_BEGIN = 1,
+        TXN_STATE_COMMIT = 2,
+        TXN_STATE_ABORT = 3
+    } txnState_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t id;
+        uint8_t state;
+    } txn_record_t;
+
+    typedef struct
+    {
+        FlashWearLevellingUtils *pRegion;
+        memory_cxt_t staged;
+        bool isStaged;
+    } participant_t;
+
+public:
+    FlashTransaction(FlashWearLevellingUtils *journal);
+    bool attach(FlashWearLevellingUtils *region);
+    bool recover();
+    bool beginTxn();
+    bool stage(FlashWearLevellingUtils *region, uint8_t *buff, uint32_t *length);
+    bool commit();
+    bool abort();
+
+    template <typename varType>
+    bool stage(FlashWearLevellingUtils *region, varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        return stage(region, (uint8_t *)data, &length) && (length == sizeof(varType));
+    } // stage
+
+private:
+    FlashWearLevellingUtils *_pJournal;
+    participant_t _participant[TXN_PARTICIPANT_MAX];
+    uint8_t _participant_cnt;
+    uint32_t _id; /* the transaction opened or the last one */
+    bool _txn_isOpen;
+    uint8_t *_pFound;
+    uint32_t _found_length;
+    uint16_t _found_type;
+    uint16_t _skip_cnt;
+    bool _isFound;
+    bool journal(uint8_t state);
+    participant_t *findParticipant(FlashWearLevellingUtils *region);
+    bool rollback(FlashWearLevellingUtils *region);
+    bool findCommitted(const memory_cxt_t *mem);
+};
+
+#endif
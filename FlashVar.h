@@ -0,0 +1,78 @@
+/** @file FlashVar.h
+ *  @brief utility support saving a variable type T into a space NAND/NOR memory,
+ *         the geometry is verified at compile time
+ *
+ *  @author tienhuyiot
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who                      Date             Changes
+ * -----  --------------------     ----------       --------------------
+ * 1.0    tienhuyiot@gmail.com     Oct 19, 2026     Initialize
+ *
+ *
+ *</pre>
+ */
+
+#ifndef __FLASH_VAR_H
+#define __FLASH_VAR_H
+
+#include "FlashWearLevellingUtils.h"
+
+/**
+ * The geometry and sizeof(T) are checked at compile time, the record length is sizeof(T)
+ * so readAt()/readRange() are available. The page math of write is the one of the base.
+ * Example:
+ *  FlashVar<flash_data_t, 0, 256, 64> u32_log;
+ *  u32_log.write(&w_data);
+ */
+template <typename T, uint32_t Start, uint32_t Size, uint16_t Page = PAGE_ERASE_SIZE_DEFAULT>
+class FlashVar : protected FlashWearLevellingUtils
+{
+    static_assert(Page > 0, "Page must be greater than 0");
+    static_assert((Start % Page) == 0, "Start must be multiples Page");
+    static_assert((Size > 0) && ((Size % Page) == 0), "Size must be multiples Page");
+    /* A record per write, readAt()/readRange() need the fixed data length */
+    static_assert(sizeof(T) <= MEMORY_LENGTH_MAX, "sizeof(T) must be MEMORY_LENGTH_MAX at most");
+    static_assert((MEMORY_HEADER_LENGTH + sizeof(T)) <= Size, "Size is not enough for a record");
+
+public:
+    FlashVar() : FlashWearLevellingUtils(Start, Size, Page, sizeof(T)) {}
+
+    using FlashWearLevellingUtils::setCallbacks;
+    using FlashWearLevellingUtils::stats;
+    using FlashWearLevellingUtils::resetStats;
+    using FlashWearLevellingUtils::writeAmplification;
+    using FlashWearLevellingUtils::lifetime;
+    using FlashWearLevellingUtils::begin;
+    using FlashWearLevellingUtils::format;
+    using FlashWearLevellingUtils::info;
+    using FlashWearLevellingUtils::history;
+
+    bool write(const T *data)
+    {
+        /* The base never modify the buffer */
+        return FlashWearLevellingUtils::write<T>(const_cast<T *>(data));
+    } // write
+
+    bool read(T *data)
+    {
+        uint32_t length = sizeof(T);
+        return FlashWearLevellingUtils::read((uint8_t *)data, &length) && (length == sizeof(T));
+    } // read
+
+    bool readAt(uint32_t k, T *data)
+    {
+        uint32_t length = sizeof(T);
+        return FlashWearLevellingUtils::readAt(k, (uint8_t *)data, &length) && (length == sizeof(T));
+    } // readAt
+
+    /* data must have (k1 - k0) elements, the newest first */
+    bool readRange(uint32_t k0, uint32_t k1, T *data)
+    {
+        return FlashWearLevellingUtils::readRange<T>(k0, k1, data);
+    } // readRange
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "FlashWearLevellingUtils.h"
 #include "util_crc32.h"
+#include "util_rle.h"
+
+static_assert(HISTORY_PREFETCH_SIZE_DEFAULT >= (16U + 256U), "prefetch window must fit a whole record");
 
 /**
  * @brief Calculator CRC32 memory.
@@ -18,6 +21,8 @@ static uint32_t fwl_header_crc32(memory_cxt_t* mem)
     return crc;
 } // fwl_header_crc32
 
+FlashWearLevellingUtils::scratch_cxt_t FlashWearLevellingUtils::_scratch = {nullptr, 0, false};
+
 FlashWearLevellingUtils::
     FlashWearLevellingUtils(uint32_t start_addr,
                             size_t memory_size,
@@ -25,14 +30,25 @@ FlashWearLevellingUtils::
                             uint16_t data_length) : _start_addr(start_addr),
                                                   _memory_size(memory_size),
                                                   _page_erase_size(page_erase_size),
-                                                  _header2data_offset_length(16U),
+                                                  _header2data_offset_length(MEMORY_HEADER_LENGTH),
                                                   _data_length(data_length)
 {
     _pCallbacks = &defaultCallback;
+    _pCompress = nullptr;
+    _pErased = nullptr;
+    _inPlace_isAllowed = true;
+    _inPlace_isEnable = false;
+    resetStats();
+    /* The geometry is never changed, verify only once */
+    _memInfo_isOK = checkMemInfo();
     headerDefault();
 } // FlashWearLevellingUtils
 
-FlashWearLevellingUtils::~FlashWearLevellingUtils() {}
+FlashWearLevellingUtils::~FlashWearLevellingUtils()
+{
+    delete[] _pCompress; /* free memory */
+    delete[] _pErased;   /* free memory */
+} // ~FlashWearLevellingUtils
 
 /**
  * Find and update current memory header
@@ -50,8 +66,23 @@ bool FlashWearLevellingUtils::begin(bool formatOnFail)
         return false;
     }
 
+    /* Nothing is known erased at mount, the pages are erased or checked blank later */
+    if (_pErased == nullptr)
+    {
+        _pErased = new (std::nothrow) uint32_t[(_memory_size / _page_erase_size + 31U) / 32U];
+    }
+    if (_pErased != nullptr)
+    {
+        memset(_pErased, 0, ((_memory_size / _page_erase_size + 31U) / 32U) * sizeof(uint32_t));
+    }
+
+    /* The byte-addressable memory keep the A/B records in place */
+    _inPlace_isEnable = _inPlace_isAllowed
+                        && _pCallbacks->onInPlaceWrite()
+                        && ((_memory_size / 2U) >= (_data_length + _header2data_offset_length));
+
     FWL_TAG_INFO("[begin] findLastHeader start");
-    if (!findLastHeader())
+    if (!(_inPlace_isEnable ? findInPlaceRecord() : findLastHeader()))
     {
         if (formatOnFail)
         {
@@ -80,29 +111,27 @@ bool FlashWearLevellingUtils::begin(bool formatOnFail)
 */
 bool FlashWearLevellingUtils::format()
 {
-    bool format = true;
+    bool format = true, blank;
 
-    /* Allocate dynamic memory */
-    uint8_t *ptr_data = new (std::nothrow) uint8_t[_page_erase_size];
-    if (ptr_data != nullptr)
+    if (_inPlace_isEnable)
+    {
+        return formatInPlace();
+    }
+
+    /* The first page is read only if it is not known erased */
+    if (pageErased(_start_addr))
+    {
+        format = false;
+    }
+    else
     {
-        uint16_t length = _page_erase_size;
         FWL_TAG_INFO("[format] verify the first page erase");
-        if (_pCallbacks->onRead(_start_addr, ptr_data, &length))
+        if (blankCheck(_start_addr, _page_erase_size, &blank))
         {
-            format = false;
-            for (int i = 0; i < length; ++i)
-            {
-                if (ptr_data[i] != 0xFF)
-                {
-                    format = true;
-                    break;
-                }
-            }
+            format = !blank;
         }
-        delete[] ptr_data;
     }
-    
+
     if (format)
     {
         /* Erase first page */
@@ -112,11 +141,13 @@ bool FlashWearLevellingUtils::format()
             FWL_TAG_INFO("[format] erase failed!");
             return false;
         }
+        ++_stats.pagesErased;
     }
     else
     {
         FWL_TAG_INFO("[format] No");
     }
+    pageMark(_start_addr, _page_erase_size, true);
     return true;
 } // format
 
@@ -125,16 +156,104 @@ bool FlashWearLevellingUtils::format()
 */
 memory_cxt_t FlashWearLevellingUtils::info()
 {
-    return _memory_cxt;
+    return _commit_cxt;
 } // info
 
-/** Write data to a region allocated
+/**
+ * Return the wear counters
+*/
+wear_stats_t FlashWearLevellingUtils::stats()
+{
+    return _stats;
+} // stats
+
+bool FlashWearLevellingUtils::inPlace()
+{
+    return _inPlace_isEnable;
+} // inPlace
+
+void FlashWearLevellingUtils::resetStats()
+{
+    memset(&_stats, 0, sizeof(wear_stats_t));
+} // resetStats
+
+float FlashWearLevellingUtils::writeAmplification()
+{
+    if (0 == _stats.payloadBytes)
+    {
+        return 0;
+    }
+
+    return (float)_stats.bytesProgrammed / (float)_stats.payloadBytes;
+} // writeAmplification
+
+/**
+ * @brief Project the remaining lifetime by the erase rate of pages since resetStats().
+ * @param [in] endurance The rated erase cycles of a page.
+ * @param [in] elapsed The time since resetStats(), any unit.
+ * @param [in] eraseCount The erase count of the most worn page, 0 if it is not known,
+ *             the average erases per page of the counters is used.
+ * @return The remaining time in the unit of elapsed, UINT32_MAX if no page is erased.
+ */
+uint32_t FlashWearLevellingUtils::lifetime(uint32_t endurance, uint32_t elapsed, uint32_t eraseCount)
+{
+    uint32_t page_cnt = _memory_size / _page_erase_size;
+    uint64_t remain;
+
+    if ((0 == _stats.pagesErased) || (0 == page_cnt))
+    {
+        return UINT32_MAX;
+    }
+
+    if (0 == eraseCount)
+    {
+        eraseCount = (_stats.pagesErased + page_cnt - 1) / page_cnt;
+    }
+
+    if (eraseCount >= endurance)
+    {
+        return 0;
+    }
+
+    /* The erases are spread over all pages of the region */
+    remain = (uint64_t)(endurance - eraseCount) * elapsed * page_cnt / _stats.pagesErased;
+    return (remain > UINT32_MAX) ? UINT32_MAX : (uint32_t)remain;
+} // lifetime
+
+/**
+ * Enable or disable RLE compression of the data not longer than MEMORY_LENGTH_MAX,
+ * the records already written are read as they were written
+*/
+bool FlashWearLevellingUtils::setCompression(bool enable)
+{
+    if (!enable)
+    {
+        delete[] _pCompress; /* free memory */
+        _pCompress = nullptr;
+        return true;
+    }
+
+    if (_pCompress == nullptr)
+    {
+        _pCompress = new (std::nothrow) uint8_t[MEMORY_LENGTH_MAX];
+        if (_pCompress == nullptr)
+        {
+            FWL_TAG_INFO("[setCompression] Allocate RAM failed!");
+            return false;
+        }
+    }
+
+    return true;
+} // setCompression
+
+/** Write data to a region allocated,
+ *  the data longer than MEMORY_LENGTH_MAX is split into chunks
  * 
  *  @param buff     Buffer of data to write
  *  @param length   Size to write in bytes
  *  @return         True if read is succeed
  */
-bool FlashWearLevellingUtils::write(uint8_t *buff, uint16_t *length)
+bool FlashWearLevellingUtils::write(uint8_t *buff, uint32_t *length)
 {
     if (!verifyMemInfo())
     {
@@ -142,12 +261,42 @@ bool FlashWearLevellingUtils::write(uint8_t *buff, uint16_t *length)
         return false;
     }
 
+    if ((*length) > MEMORY_LENGTH_MAX)
+    {
+        if (_inPlace_isEnable)
+        {
+            FWL_TAG_INFO("[write] length failed, in-place mode!");
+            return false;
+        }
+
+        if (!writeLarge(buff, *length))
+        {
+            return false;
+        }
+        _stats.payloadBytes += *length;
+        return true;
+    }
+
     memory_cxt_t w_memory = _memory_cxt;
     w_memory.data.pBuffer = buff;
     w_memory.data.length = *length;
-    if (saveData(&w_memory))
+    w_memory.header.type = MEMORY_HEADER_TYPE;
+    if (_pCompress != nullptr)
+    {
+        uint32_t compress_length = compressData(buff, *length);
+        if (compress_length > 0)
+        {
+            FWL_TAG_INFO("[write] compressed %u -> %u", *length, compress_length);
+            w_memory.data.pBuffer = _pCompress;
+            w_memory.data.length = compress_length;
+            w_memory.header.type = MEMORY_HEADER_RLE_TYPE;
+        }
+    }
+    if (_inPlace_isEnable ? saveInPlace(&w_memory) : saveData(&w_memory))
     {
         _memory_cxt = w_memory;
+        _commit_cxt = w_memory;
+        _stats.payloadBytes += *length;
         return true;
     }
     return false;
@@ -159,7 +308,7 @@ bool FlashWearLevellingUtils::write(uint8_t *buff, uint16_t *length)
  *  @param length   Size to read in bytes
  *  @return         True if read is succeed
  */
-bool FlashWearLevellingUtils::read(uint8_t *buff, uint16_t *length)
+bool FlashWearLevellingUtils::read(uint8_t *buff, uint32_t *length)
 {
     if (!verifyMemInfo())
     {
@@ -167,7 +316,22 @@ bool FlashWearLevellingUtils::read(uint8_t *buff, uint16_t *length)
         return false;
     }
 
-    if ((*length) < _memory_cxt.header.dataLength)
+    if (MEMORY_HEADER_LARGE_TYPE == _commit_cxt.header.type)
+    {
+        return readLarge(buff, length);
+    }
+
+    if (MEMORY_HEADER_RLE_TYPE == _commit_cxt.header.type)
+    {
+        return readCompressed(&_commit_cxt, buff, length);
+    }
+
+    if (MEMORY_HEADER_INTENT_TYPE == _commit_cxt.header.type)
+    {
+        return readIntent(&_commit_cxt, buff, length);
+    }
+
+    if ((*length) < _commit_cxt.header.dataLength)
     {
         FWL_TAG_INFO("[read] length buffer is not enough!");
         return false;
@@ -175,619 +339,1858 @@ bool FlashWearLevellingUtils::read(uint8_t *buff, uint16_t *length)
 
     FWL_TAG_INFO("[read] load data");
     /* Read data */
-    _memory_cxt.data.pBuffer = buff;
+    _commit_cxt.data.pBuffer = buff;
     /* The data length must be equal header data length */
-    _memory_cxt.data.length = _memory_cxt.header.dataLength;
-    if (!loadData(&_memory_cxt))
+    _commit_cxt.data.length = _commit_cxt.header.dataLength;
+    if (!loadData(&_commit_cxt))
     {
         FWL_TAG_INFO("[read] Data failed!");
         return false;
     }
 
-    FWL_TAG_INFO("[read] data length: %u", _memory_cxt.data.length);
-    *length = _memory_cxt.data.length;
+    FWL_TAG_INFO("[read] data length: %u", _commit_cxt.data.length);
+    *length = _commit_cxt.data.length;
 
     return true;
 } // read
 
-/**
- * @brief Set the callback handlers for this flash memory.
- * @param [in] pCallbacks An instance of a callbacks structure used to define any callbacks for the flash memory.
+/** Walk the records stored in the region allocated
+ *
+ *  The headers and data are prefetched by window HISTORY_PREFETCH_SIZE_DEFAULT
+ *  byte per onRead, the CRC32 of a record is verified only before it is
+ *  handed to the visitor. A record failed CRC32 (ERROR_CRC_DATA) is the end
+ *  of history, a power lost while the page after the newest header is erased
+ *  may break the oldest records. Oldest first, the records of previous round are
+ *  verified while the oldest is searched and the walk start after the newest
+ *  record failed, a record of current round failed is not visited.
+ *
+ *  @param visitor      Called for each record, return false to stop
+ *  @param count        Maximum number of record to visit
+ *  @param oldestFirst  Visit from the oldest record to the newest record
+ *  @return             True if the walk is not stopped by a read error
  */
-void FlashWearLevellingUtils::setCallbacks(FlashWearLevellingCallbacks *pCallbacks)
+bool FlashWearLevellingUtils::history(historyVisitor_t visitor, uint32_t count, bool oldestFirst)
 {
-    if (pCallbacks != nullptr)
+    prefetch_cxt_t win;
+    memory_cxt_t mem_cxt, prev_cxt;
+    uint32_t boundary, visit_cnt;
+    bool wrapped, status_isOK = true;
+
+    if (!verifyMemInfo() || _inPlace_isEnable)
     {
-        _pCallbacks = pCallbacks;
+        FWL_TAG_INFO("[history] memory info Failed or in-place mode!");
+        return false;
     }
-    else
+
+    /* The header default, this mean have not data */
+    if ((0 == _memory_cxt.header.dataLength) || (0 == count))
     {
-        _pCallbacks = &defaultCallback;
+        FWL_TAG_INFO("[history] No");
+        return true;
     }
-    FWL_TAG_INFO(">> setCallbacks: 0x%x << setCallbacks", (uint32_t)_pCallbacks);
-} // setCallbacks
-
-/**
- * @brief Find last header information.
- */
-bool FlashWearLevellingUtils::findLastHeader()
-{
-    memory_cxt_t mem_cxt = {0};
-    uint32_t find_cnt;
 
     /* Allocate dynamic memory */
-    uint8_t *ptr_data = new (std::nothrow) uint8_t[MEMORY_LENGTH_MAX];
-    if (ptr_data == NULL)
+    win.size = HISTORY_PREFETCH_SIZE_DEFAULT;
+    if (win.size > _memory_size)
     {
-        FWL_TAG_INFO("[findLastHeader] Allocate RAM failed!");
+        win.size = _memory_size;
+    }
+    win.pBuffer = scratchAlloc(win.size);
+    if (win.pBuffer == nullptr)
+    {
+        FWL_TAG_INFO("[history] Allocate RAM failed!");
         return false;
     }
-    FWL_TAG_INFO("[findLastHeader] Allocated %u byte RAM at 0x%x", MEMORY_LENGTH_MAX, (uint32_t)ptr_data);
+    win.addr = 0;
+    win.length = 0;
 
-    mem_cxt.header.nextAddr = _start_addr;
-    find_cnt = 0;
-    do
+    boundary = historyBoundary();
+    FWL_TAG_INFO("[history] boundary %u(0x%X)", boundary, boundary);
+
+    mem_cxt = _memory_cxt;
+    wrapped = false;
+    if (oldestFirst)
     {
-        /* End */
-        if (MEMORY_HEADER_END == mem_cxt.header.addr)
+        /* Find the oldest record, CRC32 of current round is verified later when it is visited */
+        visit_cnt = (MEMORY_HEADER_CHUNK_TYPE != mem_cxt.header.type) ? 1 : 0;
+        while (visit_cnt < count)
         {
-            FWL_TAG_INFO("[findLastHeader] Header Addr End!");
-            break;
+            prev_cxt = mem_cxt;
+            if (!historyPrev(&win, &prev_cxt, &wrapped, boundary))
+            {
+                break;
+            }
+
+            /* The history start after a record of previous round failed */
+            if (wrapped && (MEMORY_HEADER_CHUNK_TYPE != prev_cxt.header.type) && !verifyData(&prev_cxt))
+            {
+                break;
+            }
+            mem_cxt = prev_cxt;
+
+            if (MEMORY_HEADER_CHUNK_TYPE != mem_cxt.header.type)
+            {
+                ++visit_cnt;
+            }
         }
+        FWL_TAG_INFO("[history] oldest Addr %u(0x%X)", mem_cxt.header.addr, mem_cxt.header.addr);
+    }
 
-        /* Get header */
-        mem_cxt.header.addr = mem_cxt.header.nextAddr;
-        if (!loadHeader(&mem_cxt))
+    if (!prefetchRecord(&win, mem_cxt.header.addr, &mem_cxt, !oldestFirst))
+    {
+        FWL_TAG_INFO("[history] Read record failed!");
+        status_isOK = false;
+    }
+
+    visit_cnt = 0;
+    while (status_isOK)
+    {
+        /* The chunks are visited by their MEMORY_HEADER_LARGE_TYPE record */
+        if (MEMORY_HEADER_CHUNK_TYPE != mem_cxt.header.type)
         {
-            FWL_TAG_INFO("[findLastHeader] Read Header failed!");
-            break;
+            /* Lazy checksum, only the record handed to the visitor. The records of previous round
+                were verified to find the oldest */
+            if (!(oldestFirst && (mem_cxt.header.addr > _memory_cxt.header.addr)) && !verifyData(&mem_cxt))
+            {
+                FWL_TAG_INFO("[history] CRC32 failed!");
+                if (!oldestFirst)
+                {
+                    break;
+                }
+            }
+            else if (!visitor(&mem_cxt) || (++visit_cnt >= count))
+            {
+                break;
+            }
         }
 
-        /* Read data with the purpose is verify data content in flash memory 
-            have to succeed before next header */
-        mem_cxt.data.pBuffer = ptr_data;
-        mem_cxt.data.length = mem_cxt.header.dataLength;
-        mem_cxt.data.addr = mem_cxt.header.addr + _header2data_offset_length;
-        if (!loadData(&mem_cxt))
+        if (oldestFirst)
+        {
+            /* The newest record is reached */
+            if (mem_cxt.header.addr == _memory_cxt.header.addr)
+            {
+                break;
+            }
+
+            if (!historyNext(&win, &mem_cxt))
+            {
+                FWL_TAG_INFO("[history] chain broken!");
+                status_isOK = false;
+            }
+        }
+        else if (!historyPrev(&win, &mem_cxt, &wrapped, boundary))
         {
-            FWL_TAG_INFO("[findLastHeader] Data failed!");
             break;
         }
+    }
 
-        /* Update counter found a header */
-        find_cnt++;
-        FWL_TAG_INFO("Found %u", find_cnt);
+    FWL_TAG_INFO("[history] visited %u", visit_cnt);
+    scratchFree(win.pBuffer); /* free memory */
 
-        /* Save last mem_cxt */
-        _memory_cxt = mem_cxt;
-    } while (1);
+    return status_isOK;
+} // history
 
-    delete[] ptr_data; /* free memory */
-    FWL_TAG_INFO("[findLastHeader] Free %u byte RAM at 0x%x", MEMORY_LENGTH_MAX, (uint32_t)ptr_data);
+/** Copy the data of a record handed to a history visitor
+ *
+ *  @param mem      The record visited
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if read is succeed
+ */
+bool FlashWearLevellingUtils::recordData(const memory_cxt_t *mem, uint8_t *buff, uint32_t *length)
+{
+    if (MEMORY_HEADER_RLE_TYPE == mem->header.type)
+    {
+        return expandData(mem->data.pBuffer, mem->data.length, buff, length);
+    }
 
-    if (find_cnt > 0)
+    if (MEMORY_HEADER_INTENT_TYPE == mem->header.type)
     {
-        FWL_TAG_INFO("[findLastHeader] Final counter: %u", find_cnt);
-#if (1)
-        FWL_TAG_INFO("[findLastHeader] Addr %u(0x%X)", _memory_cxt.header.addr, _memory_cxt.header.addr);
-        FWL_TAG_INFO("[findLastHeader] crc32 0x%x", _memory_cxt.header.crc32);
-        FWL_TAG_INFO("[findLastHeader] next Addr %u(0x%X)", _memory_cxt.header.nextAddr, _memory_cxt.header.nextAddr);
-        FWL_TAG_INFO("[findLastHeader] prev Addr %u(0x%X)", _memory_cxt.header.prevAddr, _memory_cxt.header.prevAddr);
-        FWL_TAG_INFO("[findLastHeader] data length %u", _memory_cxt.header.dataLength);
-#endif
+        if ((mem->data.length < MEMORY_TXN_ID_LENGTH) || ((*length) < (mem->data.length - MEMORY_TXN_ID_LENGTH)))
+        {
+            FWL_TAG_INFO("[recordData] length buffer failed!");
+            return false;
+        }
+
+        memcpy(buff, mem->data.pBuffer + MEMORY_TXN_ID_LENGTH, mem->data.length - MEMORY_TXN_ID_LENGTH);
+        *length = mem->data.length - MEMORY_TXN_ID_LENGTH;
         return true;
     }
-    else
+
+    if ((MEMORY_HEADER_TYPE != mem->header.type) || ((*length) < mem->data.length))
     {
-        FWL_TAG_INFO("[findLastHeader] Not Found header");
-        FWL_TAG_INFO("[findLastHeader] Init header default");
-        /* Don't have any header, this mean have not data */
-        headerDefault();
+        FWL_TAG_INFO("[recordData] type or length buffer failed!");
+        return false;
     }
-    return false;
-} // findLastHeader
 
-void FlashWearLevellingUtils::headerDefault(void)
-{
-    _memory_cxt.header.addr = _start_addr;
-    _memory_cxt.header.nextAddr = _start_addr;
-    _memory_cxt.header.prevAddr = _start_addr;
-    _memory_cxt.header.crc32 = 0xFFFFFFFF;
-    _memory_cxt.header.dataLength = 0;
-    _memory_cxt.header.type = MEMORY_HEADER_TYPE;
-    _memory_cxt.data.addr = _start_addr + _header2data_offset_length;
-    _memory_cxt.data.length = 0;
-}
+    memcpy(buff, mem->data.pBuffer, mem->data.length);
+    *length = mem->data.length;
+    return true;
+} // recordData
 
-/**
- * @brief Get data from header information.
- * @param [in] memory_cxt_t The structure content variable informations.
+/** Read the record written k writes ago in fixed data length mode,
+ *  the address is computed from the newest record without walking the chain
+ *
+ *  @param k        0 is the newest record
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if read is succeed
  */
-bool FlashWearLevellingUtils::loadHeader(memory_cxt_t *mem)
+bool FlashWearLevellingUtils::readAt(uint32_t k, uint8_t *buff, uint32_t *length)
 {
-    uint16_t length;
+    memory_cxt_t mem_cxt;
 
-    if (MEMORY_HEADER_END == mem->header.addr)
-    {
-        FWL_TAG_INFO("[loadHeader] Header Addr End!");
-        return false;
-    }
-    /* Get header */
-    length = _header2data_offset_length;
-    if (!_pCallbacks->onRead(mem->header.addr, (uint8_t *)&mem->header.crc32, &length))
+    if (!verifyMemInfo() || _inPlace_isEnable)
     {
-        FWL_TAG_INFO("[loadHeader] Read Header failed!");
+        FWL_TAG_INFO("[readAt] memory info Failed or in-place mode!");
         return false;
     }
 
-    if (length != _header2data_offset_length)
+    if ((*length) < _data_length)
     {
-        FWL_TAG_INFO("[loadHeader] Read length failed!");
+        FWL_TAG_INFO("[readAt] length buffer is not enough!");
         return false;
     }
 
-#if (1)
-    FWL_TAG_INFO("[loadHeader] header.crc32 0x%X", mem->header.crc32);
-    FWL_TAG_INFO("[loadHeader] header.nextAddr %u(0x%X)", mem->header.nextAddr, mem->header.nextAddr);
-    FWL_TAG_INFO("[loadHeader] header.addr %u(0x%X)", mem->header.addr, mem->header.addr);
-    FWL_TAG_INFO("[loadHeader] header.prevAddr %u(0x%X)", mem->header.prevAddr, mem->header.prevAddr);
-    FWL_TAG_INFO("[loadHeader] header.dataLength %u", mem->header.dataLength);
-#endif
-
-    if (0xFFFFFFFF == mem->header.crc32)
+    mem_cxt.header.addr = fixedRecordAddr(k);
+    if (MEMORY_HEADER_END == mem_cxt.header.addr)
     {
-        FWL_TAG_INFO("[loadHeader] Header CRC32 failed!");
+        FWL_TAG_INFO("[readAt] record %u not available!", k);
         return false;
     }
 
-    if (mem->header.type != MEMORY_HEADER_TYPE)
+    if ((mem_cxt.header.addr > _memory_cxt.header.addr) && !fixedRecordWrapped())
     {
-        FWL_TAG_INFO("[loadHeader] Header type failed!");
+        FWL_TAG_INFO("[readAt] record %u not available!", k);
         return false;
     }
 
-    if ((mem->header.dataLength > MEMORY_LENGTH_MAX) || (0 == mem->header.dataLength))
+    if (!loadHeader(&mem_cxt) || (mem_cxt.header.dataLength != _data_length))
     {
-        FWL_TAG_INFO("[loadHeader] Header length failed!");
+        FWL_TAG_INFO("[readAt] Read Header failed!");
         return false;
     }
 
-    if ((mem->header.nextAddr != MEMORY_HEADER_END) && (mem->header.nextAddr > (_start_addr + _memory_size)))
+    mem_cxt.data.pBuffer = buff;
+    mem_cxt.data.length = _data_length;
+    mem_cxt.data.addr = mem_cxt.header.addr + _header2data_offset_length;
+    if (!loadData(&mem_cxt))
     {
-        FWL_TAG_INFO("[loadHeader] Header nextAddr failed!");
+        FWL_TAG_INFO("[readAt] Data failed!");
         return false;
     }
 
+    *length = mem_cxt.data.length;
+
     return true;
-} // loadHeader
+} // readAt
 
-/**
- * @brief Get data from header information.
- * @param [in] memory_cxt_t The structure content variable informations.
+/** Read the records written from k0 to (k1 - 1) writes ago in fixed data length mode,
+ *  the data are copied the newest first and the records are prefetched together
+ *
+ *  @param k0       The newest record of range, 0 is the newest record
+ *  @param k1       The end of range (exclusive)
+ *  @param buff     Buffer of data to read
+ *  @param length   Size to read in bytes
+ *  @return         True if read is succeed
  */
-bool FlashWearLevellingUtils::header_isDefault(void)
+bool FlashWearLevellingUtils::readRange(uint32_t k0, uint32_t k1, uint8_t *buff, uint32_t *length)
 {
-    memory_cxt_t mem = {0};
-    uint16_t length;
+    prefetch_cxt_t win;
+    memory_cxt_t mem_cxt;
+    uint32_t k;
+    bool status_isOK = true;
 
-    /* Get header */
-    mem.header.addr = _start_addr;
-    length = _header2data_offset_length;
+    if (!verifyMemInfo() || _inPlace_isEnable)
+    {
+        FWL_TAG_INFO("[readRange] memory info Failed or in-place mode!");
+        return false;
+    }
+
+    if ((k1 <= k0) || ((*length) < ((k1 - k0) * _data_length)))
+    {
+        FWL_TAG_INFO("[readRange] length buffer is not enough!");
+        return false;
+    }
+
+    /* The oldest record of range available, all newer record are available too */
+    mem_cxt.header.addr = fixedRecordAddr(k1 - 1);
+    if ((MEMORY_HEADER_END == mem_cxt.header.addr) 
+        || ((mem_cxt.header.addr > _memory_cxt.header.addr) && !fixedRecordWrapped()))
+    {
+        FWL_TAG_INFO("[readRange] record %u not available!", k1 - 1);
+        return false;
+    }
+
+    /* Allocate dynamic memory */
+    win.size = HISTORY_PREFETCH_SIZE_DEFAULT;
+    if (win.size > _memory_size)
+    {
+        win.size = _memory_size;
+    }
+    win.pBuffer = scratchAlloc(win.size);
+    if (win.pBuffer == nullptr)
+    {
+        FWL_TAG_INFO("[readRange] Allocate RAM failed!");
+        return false;
+    }
+    win.addr = 0;
+    win.length = 0;
+
+    for (k = k0; k < k1; ++k)
+    {
+        if (!prefetchRecord(&win, fixedRecordAddr(k), &mem_cxt, true)
+            || (mem_cxt.header.dataLength != _data_length))
+        {
+            FWL_TAG_INFO("[readRange] Read record %u failed!", k);
+            status_isOK = false;
+            break;
+        }
+
+        if (!verifyData(&mem_cxt))
+        {
+            FWL_TAG_INFO("[readRange] CRC32 record %u failed!", k);
+            status_isOK = false;
+            break;
+        }
+
+        memcpy(buff + (k - k0) * _data_length, mem_cxt.data.pBuffer, _data_length);
+    }
+
+    scratchFree(win.pBuffer); /* free memory */
+
+    if (status_isOK)
+    {
+        *length = (k1 - k0) * _data_length;
+    }
+
+    return status_isOK;
+} // readRange
+
+/**
+ * @brief Set the callback handlers for this flash memory.
+ * @param [in] pCallbacks An instance of a callbacks structure used to define any callbacks for the flash memory.
+ */
+void FlashWearLevellingUtils::setCallbacks(FlashWearLevellingCallbacks *pCallbacks)
+{
+    if (pCallbacks != nullptr)
+    {
+        _pCallbacks = pCallbacks;
+    }
+    else
+    {
+        _pCallbacks = &defaultCallback;
+    }
+    FWL_TAG_INFO(">> setCallbacks: 0x%x << setCallbacks", (uint32_t)_pCallbacks);
+} // setCallbacks
+
+/**
+ * @brief Share a buffer between all instances for the temporary RAM,
+ *        a request larger than size or while the buffer is busy is allocated from heap.
+ * @param [in] buff The buffer, nullptr to use only heap.
+ * @param [in] size The size of buffer.
+ */
+void FlashWearLevellingUtils::setScratch(uint8_t *buff, uint32_t size)
+{
+    _scratch.pBuffer = buff;
+    _scratch.size = (buff != nullptr) ? size : 0;
+    _scratch.isBusy = false;
+} // setScratch
+
+/**
+ * @brief The owner of a buffer stop sharing it before free, a buffer shared
+ *        by another owner after it is kept.
+ * @param [in] buff The buffer of owner.
+ */
+void FlashWearLevellingUtils::releaseScratch(const uint8_t *buff)
+{
+    if ((buff != nullptr) && (buff == _scratch.pBuffer))
+    {
+        setScratch(nullptr, 0);
+    }
+} // releaseScratch
+
+/**
+ * @brief Get a temporary buffer, the shared scratch if it is free.
+ */
+uint8_t *FlashWearLevellingUtils::scratchAlloc(uint32_t size)
+{
+    if ((_scratch.pBuffer != nullptr) && !_scratch.isBusy && (size <= _scratch.size))
+    {
+        _scratch.isBusy = true;
+        return _scratch.pBuffer;
+    }
+
+    return new (std::nothrow) uint8_t[size];
+} // scratchAlloc
+
+void FlashWearLevellingUtils::scratchFree(uint8_t *buff)
+{
+    if ((buff != nullptr) && (buff == _scratch.pBuffer))
+    {
+        _scratch.isBusy = false;
+        return;
+    }
+
+    delete[] buff;
+} // scratchFree
+
+/**
+ * @brief Find last header information.
+ */
+bool FlashWearLevellingUtils::findLastHeader()
+{
+    memory_cxt_t mem_cxt = {0};
+    uint32_t find_cnt;
+    bool commit_found = false;
+
+    /* Allocate dynamic memory */
+    uint8_t *ptr_data = scratchAlloc(MEMORY_LENGTH_MAX);
+    if (ptr_data == NULL)
+    {
+        FWL_TAG_INFO("[findLastHeader] Allocate RAM failed!");
+        return false;
+    }
+    FWL_TAG_INFO("[findLastHeader] Allocated %u byte RAM at 0x%x", MEMORY_LENGTH_MAX, (uint32_t)ptr_data);
+
+    mem_cxt.header.nextAddr = _start_addr;
+    find_cnt = 0;
+    do
+    {
+        /* End */
+        if (MEMORY_HEADER_END == mem_cxt.header.addr)
+        {
+            FWL_TAG_INFO("[findLastHeader] Header Addr End!");
+            break;
+        }
+
+        /* Get header */
+        mem_cxt.header.addr = mem_cxt.header.nextAddr;
+        if (!loadHeader(&mem_cxt))
+        {
+            FWL_TAG_INFO("[findLastHeader] Read Header failed!");
+            break;
+        }
+
+        /* Read data with the purpose is verify data content in flash memory 
+            have to succeed before next header */
+        mem_cxt.data.pBuffer = ptr_data;
+        mem_cxt.data.length = mem_cxt.header.dataLength;
+        mem_cxt.data.addr = mem_cxt.header.addr + _header2data_offset_length;
+        if (!loadData(&mem_cxt))
+        {
+            FWL_TAG_INFO("[findLastHeader] Data failed!");
+            break;
+        }
+
+        /* Update counter found a header */
+        find_cnt++;
+        FWL_TAG_INFO("Found %u", find_cnt);
+
+        /* Save last mem_cxt */
+        _memory_cxt = mem_cxt;
+        if (MEMORY_HEADER_CHUNK_TYPE != mem_cxt.header.type)
+        {
+            _commit_cxt = mem_cxt;
+            commit_found = true;
+        }
+    } while (1);
+
+    scratchFree(ptr_data); /* free memory */
+    FWL_TAG_INFO("[findLastHeader] Free %u byte RAM at 0x%x", MEMORY_LENGTH_MAX, (uint32_t)ptr_data);
+
+    if (find_cnt > 0)
+    {
+        FWL_TAG_INFO("[findLastHeader] Final counter: %u", find_cnt);
+#if (1)
+        FWL_TAG_INFO("[findLastHeader] Addr %u(0x%X)", _memory_cxt.header.addr, _memory_cxt.header.addr);
+        FWL_TAG_INFO("[findLastHeader] crc32 0x%x", _memory_cxt.header.crc32);
+        FWL_TAG_INFO("[findLastHeader] next Addr %u(0x%X)", _memory_cxt.header.nextAddr, _memory_cxt.header.nextAddr);
+        FWL_TAG_INFO("[findLastHeader] prev Addr %u(0x%X)", _memory_cxt.header.prevAddr, _memory_cxt.header.prevAddr);
+        FWL_TAG_INFO("[findLastHeader] data length %u", _memory_cxt.header.dataLength);
+#endif
+        if (!commit_found)
+        {
+            /* The chunks of large data was not committed, the last committed record 
+                is in previous round */
+            FWL_TAG_INFO("[findLastHeader] find committed record");
+            _commit_cxt.header.dataLength = 0;
+            history(historyVisitor_t(this, &FlashWearLevellingUtils::commitRecord), 1);
+        }
+        return true;
+    }
+    else
+    {
+        FWL_TAG_INFO("[findLastHeader] Not Found header");
+        FWL_TAG_INFO("[findLastHeader] Init header default");
+        /* Don't have any header, this mean have not data */
+        headerDefault();
+    }
+    return false;
+} // findLastHeader
+
+/**
+ * @brief Find the record of in-place mode, the headers of slot A and B are read.
+ *        The prevAddr of header is the generation, the newest valid slot is the current.
+ */
+bool FlashWearLevellingUtils::findInPlaceRecord()
+{
+    memory_cxt_t slot_cxt[2];
+    bool slot_isOK[2], found = false;
+    uint8_t slot, newest;
+
+    /* Allocate dynamic memory */
+    uint8_t *ptr_data = scratchAlloc(MEMORY_LENGTH_MAX);
+    if (ptr_data == NULL)
+    {
+        FWL_TAG_INFO("[findInPlaceRecord] Allocate RAM failed!");
+        return false;
+    }
+
+    for (slot = 0; slot < 2U; ++slot)
+    {
+        memset(&slot_cxt[slot], 0, sizeof(memory_cxt_t));
+        slot_cxt[slot].header.addr = inPlaceAddr(slot);
+        slot_isOK[slot] = loadHeader(&slot_cxt[slot])
+                          && ((slot_cxt[slot].header.dataLength + _header2data_offset_length) <= (_memory_size / 2U))
+                          && (slot_cxt[slot].header.nextAddr == (slot_cxt[slot].header.addr + _header2data_offset_length + slot_cxt[slot].header.dataLength));
+    }
+
+    /* The newest generation first, the other slot if the data of it failed */
+    newest = (slot_isOK[1] && (!slot_isOK[0] || ((int32_t)(slot_cxt[1].header.prevAddr - slot_cxt[0].header.prevAddr) > 0))) ? 1U : 0U;
+    for (uint8_t i = 0; (i < 2U) && !found; ++i)
+    {
+        slot = newest ^ i;
+        if (!slot_isOK[slot])
+        {
+            continue;
+        }
+
+        slot_cxt[slot].data.pBuffer = ptr_data;
+        slot_cxt[slot].data.length = slot_cxt[slot].header.dataLength;
+        slot_cxt[slot].data.addr = slot_cxt[slot].header.addr + _header2data_offset_length;
+        if (loadData(&slot_cxt[slot]))
+        {
+            FWL_TAG_INFO("[findInPlaceRecord] slot %u generation %u", slot, slot_cxt[slot].header.prevAddr);
+            _memory_cxt = slot_cxt[slot];
+            _commit_cxt = slot_cxt[slot];
+            found = true;
+        }
+    }
+
+    scratchFree(ptr_data); /* free memory */
+
+    if (!found)
+    {
+        FWL_TAG_INFO("[findInPlaceRecord] Not Found record");
+        headerDefault();
+    }
+    return found;
+} // findInPlaceRecord
+
+/**
+ * @brief Rewrite the slot is not the current without erase, the data first and the header
+ *        last. The old header of the slot mismatch the new data if the write is lost.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::saveInPlace(memory_cxt_t *mem)
+{
+    uint32_t length;
+    bool current_isOK = (0 != _memory_cxt.header.dataLength);
+    uint8_t slot = (current_isOK && (inPlaceAddr(0) == _memory_cxt.header.addr)) ? 1U : 0U;
+
+    if ((mem->data.pBuffer == NULL) || (0 == mem->data.length)
+        || ((mem->data.length + _header2data_offset_length) > (_memory_size / 2U)))
+    {
+        FWL_TAG_INFO("[saveInPlace] Data length failed!");
+        return false;
+    }
+
+    mem->header.addr = inPlaceAddr(slot);
+    mem->header.nextAddr = mem->header.addr + _header2data_offset_length + mem->data.length;
+    /* The generation */
+    mem->header.prevAddr = current_isOK ? (_memory_cxt.header.prevAddr + 1U) : 0;
+    mem->header.dataLength = mem->data.length;
+    mem->data.addr = mem->header.addr + _header2data_offset_length;
+    mem->header.crc32 = fwl_header_crc32(mem);
+    FWL_TAG_INFO("[saveInPlace] slot %u generation %u", slot, mem->header.prevAddr);
+
+    length = mem->data.length;
+    if (!_pCallbacks->onWrite(mem->data.addr, mem->data.pBuffer, &length) || (length != mem->data.length))
+    {
+        FWL_TAG_INFO("[saveInPlace] Write Data failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+        return false;
+    }
+
+    length = _header2data_offset_length;
+    if (!_pCallbacks->onWrite(mem->header.addr, (uint8_t *)&mem->header.crc32, &length) || (length != _header2data_offset_length))
+    {
+        FWL_TAG_INFO("[saveInPlace] Write Header failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+        return false;
+    }
+
+    _stats.bytesProgrammed += _header2data_offset_length + mem->data.length;
+    ++_stats.recordsWritten;
+    return true;
+} // saveInPlace
+
+/**
+ * @brief Format in-place mode, the CRC32 of header of slot A and B are rewritten blank.
+ */
+bool FlashWearLevellingUtils::formatInPlace()
+{
+    uint32_t blank = MEMORY_HEADER_END, length;
+
+    for (uint8_t slot = 0; slot < 2U; ++slot)
+    {
+        length = sizeof(uint32_t);
+        if (!_pCallbacks->onWrite(inPlaceAddr(slot), (uint8_t *)&blank, &length) || (length != sizeof(uint32_t)))
+        {
+            FWL_TAG_INFO("[formatInPlace] write failed!");
+            return false;
+        }
+        _stats.bytesProgrammed += length;
+    }
+
+    return true;
+} // formatInPlace
+
+/**
+ * @brief The address of slot A (0) or B (1) of in-place mode.
+ */
+uint32_t FlashWearLevellingUtils::inPlaceAddr(uint8_t slot)
+{
+    return _start_addr + slot * (_memory_size / 2U);
+} // inPlaceAddr
+
+void FlashWearLevellingUtils::headerDefault(void)
+{
+    _memory_cxt.header.addr = _start_addr;
+    _memory_cxt.header.nextAddr = _start_addr;
+    _memory_cxt.header.prevAddr = _start_addr;
+    _memory_cxt.header.crc32 = 0xFFFFFFFF;
+    _memory_cxt.header.dataLength = 0;
+    _memory_cxt.header.type = MEMORY_HEADER_TYPE;
+    _memory_cxt.data.addr = _start_addr + _header2data_offset_length;
+    _memory_cxt.data.length = 0;
+    _commit_cxt = _memory_cxt;
+}
+
+/**
+ * @brief Get data from header information.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::loadHeader(memory_cxt_t *mem)
+{
+    uint32_t length;
+
+    if (MEMORY_HEADER_END == mem->header.addr)
+    {
+        FWL_TAG_INFO("[loadHeader] Header Addr End!");
+        return false;
+    }
+    /* Get header */
+    length = _header2data_offset_length;
+    if (!_pCallbacks->onRead(mem->header.addr, (uint8_t *)&mem->header.crc32, &length))
+    {
+        FWL_TAG_INFO("[loadHeader] Read Header failed!");
+        return false;
+    }
+
+    if (length != _header2data_offset_length)
+    {
+        FWL_TAG_INFO("[loadHeader] Read length failed!");
+        return false;
+    }
+
+#if (1)
+    FWL_TAG_INFO("[loadHeader] header.crc32 0x%X", mem->header.crc32);
+    FWL_TAG_INFO("[loadHeader] header.nextAddr %u(0x%X)", mem->header.nextAddr, mem->header.nextAddr);
+    FWL_TAG_INFO("[loadHeader] header.addr %u(0x%X)", mem->header.addr, mem->header.addr);
+    FWL_TAG_INFO("[loadHeader] header.prevAddr %u(0x%X)", mem->header.prevAddr, mem->header.prevAddr);
+    FWL_TAG_INFO("[loadHeader] header.dataLength %u", mem->header.dataLength);
+#endif
+
+    return checkHeader(mem);
+} // loadHeader
+
+/**
+ * @brief Check header information without report status, the header is
+ *        possible the end of chain when walking the memory.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::checkHeader(memory_cxt_t *mem)
+{
+    if (0xFFFFFFFF == mem->header.crc32)
+    {
+        FWL_TAG_INFO("[checkHeader] Header CRC32 failed!");
+        return false;
+    }
+
+    if (!headerType_isValid(mem->header.type))
+    {
+        FWL_TAG_INFO("[checkHeader] Header type failed!");
+        return false;
+    }
+
+    if ((mem->header.dataLength > MEMORY_LENGTH_MAX) || (0 == mem->header.dataLength))
+    {
+        FWL_TAG_INFO("[checkHeader] Header length failed!");
+        return false;
+    }
+
+    if ((mem->header.nextAddr != MEMORY_HEADER_END) && (mem->header.nextAddr > (_start_addr + _memory_size)))
+    {
+        FWL_TAG_INFO("[checkHeader] Header nextAddr failed!");
+        return false;
+    }
+
+    return true;
+} // checkHeader
+
+/**
+ * @brief The type of header is known.
+ */
+bool FlashWearLevellingUtils::headerType_isValid(uint16_t type)
+{
+    switch (type)
+    {
+    case MEMORY_HEADER_TYPE:
+    case MEMORY_HEADER_CHUNK_TYPE:
+    case MEMORY_HEADER_LARGE_TYPE:
+    case MEMORY_HEADER_RLE_TYPE:
+    case MEMORY_HEADER_INTENT_TYPE:
+        return true;
+    default:
+        return false;
+    }
+} // headerType_isValid
+
+/**
+ * @brief Get data from header information.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::header_isDefault(void)
+{
+    memory_cxt_t mem = {0};
+    uint32_t length;
+
+    /* Get header */
+    mem.header.addr = _start_addr;
+    length = _header2data_offset_length;
     if (!_pCallbacks->onRead(mem.header.addr, (uint8_t *)&mem.header.crc32, &length))
     {
-        FWL_TAG_INFO("[header_isDefault] Read Header failed!");
+        FWL_TAG_INFO("[header_isDefault] Read Header failed!");
+        return false;
+    }
+
+    if (length != _header2data_offset_length)
+    {
+        FWL_TAG_INFO("[header_isDefault] Read length failed!");
+        return false;
+    }
+
+    if ((0xFFFFFFFF != mem.header.crc32)
+        || (_start_addr != mem.header.nextAddr)
+        || (_start_addr != mem.header.prevAddr)
+        || (0 != mem.header.dataLength)
+        || (MEMORY_HEADER_TYPE != mem.header.type))
+    {
+        FWL_TAG_INFO("[header_isDefault] false!");
+        return false;
+    }
+
+#if (1)
+    FWL_TAG_INFO("[header_isDefault] true!");
+    FWL_TAG_INFO("[header_isDefault] crc32 0x%X", mem.header.crc32);
+    FWL_TAG_INFO("[header_isDefault] header.nextAddr %u(0x%X)", mem.header.nextAddr, mem.header.nextAddr);
+    FWL_TAG_INFO("[header_isDefault] header.addr %u(0x%X)", mem.header.addr, mem.header.addr);
+    FWL_TAG_INFO("[header_isDefault] header.prevAddr %u(0x%X)", mem.header.prevAddr, mem.header.prevAddr);
+    FWL_TAG_INFO("[header_isDefault] header.dataLength %u", mem.header.dataLength);
+#endif
+
+    return true;
+} // header_isDefault
+
+/**
+ * @brief set header into flash memory from header information.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ * @Notify data buffer, data length and header type must be available before call saveHeader()
+ */
+bool FlashWearLevellingUtils::saveHeader(memory_cxt_t *mem)
+{
+    memory_cxt_t temp = *mem;
+
+    if (mem->data.pBuffer == NULL)
+    {
+        FWL_TAG_INFO("[saveHeader] Data buffer NULL");
+        return false;
+    }
+
+    if ((mem->data.length > MEMORY_LENGTH_MAX) || (0 == mem->data.length))
+    {
+        FWL_TAG_INFO("[saveHeader] Data length failed!");
+        return false;
+    }
+
+    /* Make header prev address */
+    mem->header.prevAddr = temp.header.addr;
+    /* Make header address */
+    mem->header.addr = temp.header.nextAddr;
+    /* Make header next address */
+    mem->header.nextAddr = temp.header.nextAddr;
+    mem->header.nextAddr += _header2data_offset_length;
+    mem->header.nextAddr += temp.data.length;
+    /* the space remain memory is not enough fill data */
+    if (mem->header.nextAddr > (_start_addr + _memory_size))
+    {
+        FWL_TAG_INFO("[saveHeader] Reset address");
+        /* Reset address header base equal _start_addr */
+        mem->header.addr = _start_addr;
+        /* Make header next address again */
+        mem->header.nextAddr = _start_addr;
+        mem->header.nextAddr += _header2data_offset_length;
+        mem->header.nextAddr += temp.data.length;
+
+        /* Reset temp header address */
+        temp.header.nextAddr = _start_addr;
+
+        /* Erase first page */
+        FWL_TAG_INFO("[saveHeader] erase first page");
+        if (!_pCallbacks->onErase(_start_addr, _page_erase_size))
+        {
+            FWL_TAG_INFO("[saveHeader] erase failed!");
+            return false;
+        }
+        ++_stats.pagesErased;
+        pageMark(_start_addr, _page_erase_size, true);
+    }
+    /* Make header data length */
+    mem->header.dataLength = temp.data.length;
+    /* Make data address */
+    mem->data.addr = temp.header.nextAddr + _header2data_offset_length;
+    /* Make CRC */
+    mem->header.crc32 = fwl_header_crc32(mem);
+
+#if (1)
+    FWL_TAG_INFO("[saveHeader] header.crc32 0x%X", mem->header.crc32);
+    FWL_TAG_INFO("[saveHeader] header.nextAddr %u(0x%X)", mem->header.nextAddr, mem->header.nextAddr);
+    FWL_TAG_INFO("[saveHeader] header.addr %u(0x%X)", mem->header.addr, mem->header.addr);
+    FWL_TAG_INFO("[saveHeader] header.prevAddr %u(0x%X)", mem->header.prevAddr, mem->header.prevAddr);
+    FWL_TAG_INFO("[saveHeader] header.dataLength %u", mem->header.dataLength);
+#endif
+
+    uint32_t length = _header2data_offset_length;
+    if (!submitData(mem->header.addr, (uint8_t *)&mem->header.crc32, &length))
+    {
+        FWL_TAG_INFO("[saveHeader] Write Data failed!");
+        return false;
+    }
+
+    if (length != _header2data_offset_length)
+    {
+        FWL_TAG_INFO("[saveHeader] Write length failed!");
+        return false;
+    }
+
+    return true;
+} // saveHeader
+
+/**
+ * @brief verify header header information.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::verifyHeader(memory_cxt_t *mem)
+{
+    if (0xFFFFFFFF == mem->header.crc32)
+    {
+        FWL_TAG_INFO("[verifyHeader] Header CRC32 failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_HEADER);
+        return false;
+    }
+
+    if (!headerType_isValid(mem->header.type))
+    {
+        FWL_TAG_INFO("[verifyHeader] Header type failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_TYPE_HEADER);
+        return false;
+    }
+
+    if ((mem->header.dataLength > MEMORY_LENGTH_MAX) || (0 == mem->header.dataLength))
+    {
+        FWL_TAG_INFO("[verifyHeader] Header length failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_SIZE_HEADER);
+        return false;
+    }
+
+    if ((mem->header.nextAddr != MEMORY_HEADER_END) && (mem->header.nextAddr > (_start_addr + _memory_size)))
+    {
+        FWL_TAG_INFO("[verifyHeader] Header nextAddr failed!");
+        return false;
+    }
+
+    return true;
+} // verifyHeader
+
+/**
+ * @brief Get data from header information.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::loadData(memory_cxt_t *mem)
+{
+    FWL_TAG_INFO("[loadData] verifyHeader");
+    if (!verifyHeader(mem))
+    {
+        FWL_TAG_INFO("[loadData] header failed!");
+        return false;
+    }
+
+    if (mem->data.pBuffer == NULL)
+    {
+        FWL_TAG_INFO("[loadData] Data buffer NULL");
+        return false;
+    }
+
+    if ((mem->data.length > MEMORY_LENGTH_MAX) || (0 == mem->data.length))
+    {
+        FWL_TAG_INFO("[loadData] Data length failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_SIZE_DATA);
+        return false;
+    }
+
+    /* Get data */
+    if (!_pCallbacks->onRead(mem->data.addr, mem->data.pBuffer, &mem->data.length))
+    {
+        FWL_TAG_INFO("[loadData] Read Data failed!");
+        return false;
+    }
+
+    if (mem->data.length != mem->header.dataLength)
+    {
+        FWL_TAG_INFO("[loadData] Read length failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_READ_DATA);
+        return false;
+    }
+
+    /* Checksum */
+    FWL_TAG_INFO("[loadData] fwl_header_crc32");
+    if (fwl_header_crc32(mem) != mem->header.crc32)
+    {
+        FWL_TAG_INFO("[loadData] CRC32 header failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_DATA);
+        return false;
+    }
+
+#if (1)
+    FWL_TAG_INFO("[loadData] addr %u(0x%x)", mem->data.addr, mem->data.addr);
+    FWL_TAG_INFO("[loadData] length %u", mem->data.length);
+    FWL_TAG_INFO("[loadData] CRC32 succeed!");
+#endif
+
+    return true;
+} // loadData
+
+/**
+ * @brief Verify CRC32 of data already in the buffer.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::verifyData(memory_cxt_t *mem)
+{
+    if (fwl_header_crc32(mem) != mem->header.crc32)
+    {
+        FWL_TAG_INFO("[verifyData] CRC32 failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_DATA);
+        return false;
+    }
+
+    return true;
+} // verifyData
+
+/**
+ * @brief set data from header information.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::saveData(memory_cxt_t *mem)
+{
+    FWL_TAG_INFO("[saveData] save header");
+    if (!saveHeader(mem))
+    {
+        FWL_TAG_INFO("[saveData] header failed!");
+        return false;
+    }
+
+    /* write data */
+    FWL_TAG_INFO("[saveData] save data");
+    if (!submitData(mem->data.addr, mem->data.pBuffer, &mem->data.length))
+    {
+        FWL_TAG_INFO("[saveData] Write Data failed!");
+        return false;
+    }
+
+    if (mem->data.length != mem->header.dataLength)
+    {
+        FWL_TAG_INFO("[saveData] Write length failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
+        return false;
+    }
+    ++_stats.recordsWritten;
+
+    /* Erase CRC next header */
+#if (0) /* Not need, because The flash must be erase before write anything */
+    if ((mem->header.nextAddr + 4) <= (_start_addr + _memory_size))
+    {
+        uint8_t buff[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+        uint32_t length = 4;
+
+        if (!submitData(mem->header.nextAddr, buff, &length))
+        {
+            FWL_TAG_INFO("[saveData] Erase CRC failed!");
+            return false;
+        }
+        if (length != 4)
+        {
+            FWL_TAG_INFO("[saveData] Erase CRC length failed!");
+            return false;
+        }
+    }
+#endif
+
+#if (1)
+    FWL_TAG_INFO("[saveData] addr %u(0x%x)", mem->data.addr, mem->data.addr);
+    FWL_TAG_INFO("[saveData] length %u", mem->data.length);
+    FWL_TAG_INFO("[saveData] succeed");
+#endif
+
+    return true;
+} // saveData
+
+/**
+ * @brief writeout data.
+ * @param [in] addr The address write into flash.
+ * @param [in] buff The buffer data write into flash.
+ * @param [in] length The length of buffer write into flash.
+ */
+bool FlashWearLevellingUtils::submitData(uint32_t addr, uint8_t *buff, uint32_t *length)
+{
+    if (!eraseData(addr, *length))
+    {
+        FWL_TAG_INFO("[submitData] erase failed!");
+        return false;
+    }
+
+    if (!_pCallbacks->onWrite(addr, buff, length))
+    {
+        FWL_TAG_INFO("[submitData] write failed!");
+        return false;
+    }
+
+    _stats.bytesProgrammed += *length;
+    pageMark(addr, *length, false);
+    return true;
+} // submitData
+
+/**
+ * @brief erase data from header information.
+ * @param [in] memory_cxt_t The structure content variable informations.
+ */
+bool FlashWearLevellingUtils::eraseData(uint32_t addr, uint32_t length)
+{
+    uint32_t offset_addr, remain_size, erase_addr, first_addr, page_erase_cnt;
+    bool status_isOK = true;
+
+    offset_addr = addr % _page_erase_size;
+    remain_size = _page_erase_size - offset_addr;
+    erase_addr = addr + remain_size;
+
+    FWL_TAG_INFO("[eraseData] addr in: %u(0x%x)", addr, addr);
+    FWL_TAG_INFO("[eraseData] length in: %u", length);
+    FWL_TAG_INFO("[eraseData] remain_size: %u", remain_size);
+
+    /* Write data with write_length 
+        uint32_t write_length;
+        if (length >= remain_size)
+        {
+            write_length = remain_size;
+        }
+        else
+        {
+            write_length = length;
+        }
+        _pCallbacks->onWrite(addr, buff, write_length);
+    */
+    page_erase_cnt = 0;
+    while (length >= remain_size)
+    {
+        FWL_TAG_INFO("[eraseData] erase_addr: %u", erase_addr);
+
+        if (erase_addr == (_start_addr + _memory_size) && (length == remain_size))
+        {
+            FWL_TAG_INFO("[eraseData] last page");
+            break;
+        }
+
+        /* Assert memory size */
+        if ((erase_addr + _page_erase_size) > (_start_addr + _memory_size))
+        {
+            FWL_TAG_INFO("[eraseData] addr failed!");
+            status_isOK = false;
+            break;
+        }
+
+        /* The pages are contiguous, erased together. A page known erased is skipped */
+        if (pageErased(erase_addr))
+        {
+            FWL_TAG_INFO("[eraseData] page is erased");
+            if ((page_erase_cnt > 0) && !eraseRange(first_addr, page_erase_cnt))
+            {
+                return false;
+            }
+            page_erase_cnt = 0;
+        }
+        else
+        {
+            if (0 == page_erase_cnt)
+            {
+                first_addr = erase_addr;
+            }
+            ++page_erase_cnt;
+        }
+
+        /* Remain Length */
+        length -= remain_size;
+        /* Write data with write_length
+            if (length >= _page_erase_size)
+            {
+                write_length = _page_erase_size;
+            }
+            else
+            {
+                write_length = length;
+            }
+
+            if(write_length > 0)
+            {
+                _pCallbacks->onWrite(erase_addr, buff, write_length);
+            }
+        */
+
+        /* new remain size is equal page size */
+        remain_size = _page_erase_size;
+
+        /* update address to erase next page */
+        erase_addr += _page_erase_size;
+
+        FWL_TAG_INFO("[eraseData] remain length: %u", length);
+        FWL_TAG_INFO("[eraseData] remain_size: %u", remain_size);
+    } // while (length >= remain_size)
+
+    /* Erase next pages, by the largest block erase supported */
+    if (status_isOK && (page_erase_cnt > 0) && !eraseRange(first_addr, page_erase_cnt))
+    {
+        return false;
+    }
+
+    return status_isOK;
+} // eraseData
+
+/**
+ * @brief Erase contiguous pages and mark them erased.
+ * @param [in] addr The address of the first page.
+ * @param [in] page_cnt The number of pages.
+ */
+bool FlashWearLevellingUtils::eraseRange(uint32_t addr, uint32_t page_cnt)
+{
+    if (!_pCallbacks->eraseRange(addr, page_cnt * _page_erase_size, _page_erase_size))
+    {
+        FWL_TAG_INFO("[eraseRange] erase failed!");
         return false;
     }
 
-    if (length != _header2data_offset_length)
+    FWL_TAG_INFO("[eraseRange] page number is erased: %u", page_cnt);
+    _stats.pagesErased += page_cnt;
+    pageMark(addr, page_cnt * _page_erase_size, true);
+    return true;
+} // eraseRange
+
+/**
+ * @brief The page of addr is erased and not programmed since.
+ */
+bool FlashWearLevellingUtils::pageErased(uint32_t addr)
+{
+    uint32_t page = (addr - _start_addr) / _page_erase_size;
+
+    if ((_pErased == nullptr) || (addr < _start_addr) || (addr >= (_start_addr + _memory_size)))
     {
-        FWL_TAG_INFO("[header_isDefault] Read length failed!");
         return false;
     }
 
-    if ((0xFFFFFFFF != mem.header.crc32)
-        || (_start_addr != mem.header.nextAddr)
-        || (_start_addr != mem.header.prevAddr)
-        || (0 != mem.header.dataLength)
-        || (MEMORY_HEADER_TYPE != mem.header.type))
+    return (_pErased[page / 32U] >> (page % 32U)) & 1U;
+} // pageErased
+
+/**
+ * @brief Mark the pages of a range erased, or programmed.
+ */
+void FlashWearLevellingUtils::pageMark(uint32_t addr, uint32_t length, bool erased)
+{
+    uint32_t page, last;
+
+    if ((_pErased == nullptr) || (0 == length))
     {
-        FWL_TAG_INFO("[header_isDefault] false!");
+        return;
+    }
+
+    page = (addr - _start_addr) / _page_erase_size;
+    last = (addr + length - 1 - _start_addr) / _page_erase_size;
+    for (; (page <= last) && (page < (_memory_size / _page_erase_size)); ++page)
+    {
+        if (erased)
+        {
+            _pErased[page / 32U] |= (1U << (page % 32U));
+        }
+        else
+        {
+            _pErased[page / 32U] &= ~(1U << (page % 32U));
+        }
+    }
+} // pageMark
+
+/**
+ * @brief Read a range by small chunks and compare them by word, stop at the first byte is not 0xFF.
+ * @param [out] blank The range is blank.
+ */
+bool FlashWearLevellingUtils::blankCheck(uint32_t addr, uint32_t length, bool *blank)
+{
+    uint32_t chunk[16]; /* 64-byte of stack */
+    uint32_t offset, read_length, i;
+
+    *blank = false;
+    for (offset = 0; offset < length; offset += sizeof(chunk))
+    {
+        read_length = ((length - offset) < sizeof(chunk)) ? (length - offset) : sizeof(chunk);
+        if (!_pCallbacks->onRead(addr + offset, (uint8_t *)chunk, &read_length))
+        {
+            FWL_TAG_INFO("[blankCheck] read failed!");
+            return false;
+        }
+
+        /* The tail of a short chunk is filled to compare by word */
+        memset((uint8_t *)chunk + read_length, 0xFF, sizeof(chunk) - read_length);
+        for (i = 0; i < (sizeof(chunk) / sizeof(uint32_t)); ++i)
+        {
+            if (UINT32_MAX != chunk[i])
+            {
+                return true;
+            }
+        }
+    }
+
+    *blank = true;
+    return true;
+} // blankCheck
+
+/**
+ * verify memory information, the result of checkMemInfo() at constructor
+*/
+bool FlashWearLevellingUtils::verifyMemInfo()
+{
+    return _memInfo_isOK;
+} // verifyMemInfo
+
+/**
+ * check memory information
+*/
+bool FlashWearLevellingUtils::checkMemInfo()
+{
+    if ((_start_addr % _page_erase_size))
+    {
+        FWL_TAG_INFO("[checkMemInfo][error] _start_addr must be multiples _page_erase_size");
         return false;
     }
 
-#if (1)
-    FWL_TAG_INFO("[header_isDefault] true!");
-    FWL_TAG_INFO("[header_isDefault] crc32 0x%X", mem.header.crc32);
-    FWL_TAG_INFO("[header_isDefault] header.nextAddr %u(0x%X)", mem.header.nextAddr, mem.header.nextAddr);
-    FWL_TAG_INFO("[header_isDefault] header.addr %u(0x%X)", mem.header.addr, mem.header.addr);
-    FWL_TAG_INFO("[header_isDefault] header.prevAddr %u(0x%X)", mem.header.prevAddr, mem.header.prevAddr);
-    FWL_TAG_INFO("[header_isDefault] header.dataLength %u", mem.header.dataLength);
-#endif
+    if ((0 == _memory_size) || (_memory_size % _page_erase_size))
+    {
+        FWL_TAG_INFO("[checkMemInfo][error] _memory_size must be multiples _page_erase_size");
+        return false;
+    }
+
+    if ((_data_length + _header2data_offset_length) > _memory_size)
+    {
+        FWL_TAG_INFO("[checkMemInfo][error] _memory_size is not enough, min = %u", _data_length + _header2data_offset_length);
+        return false;
+    }
 
     return true;
-} // header_isDefault
+} // checkMemInfo
 
 /**
- * @brief set header into flash memory from header information.
- * @param [in] memory_cxt_t The structure content variable informations.
- * @Notify data buffer and data length must be available before call saveHeader()
+ * @brief Write large data as chunks of MEMORY_LENGTH_MAX byte, then commit by 
+ *        a MEMORY_HEADER_LARGE_TYPE record. The chunks without commit are ignored.
+ *        The last committed record is kept until the commit, so the committed and
+ *        the new record must fit the memory together, about half of it each.
+ * @param [in] buff The buffer data write into flash.
+ * @param [in] length The length of buffer write into flash.
  */
-bool FlashWearLevellingUtils::saveHeader(memory_cxt_t *mem)
+bool FlashWearLevellingUtils::writeLarge(uint8_t *buff, uint32_t length)
 {
-    memory_cxt_t temp = *mem;
+    large_cxt_t large;
+    memory_cxt_t mem_cxt;
+    uint32_t offset, chunk_cnt, span, kept, first_addr;
 
-    if (mem->data.pBuffer == NULL)
+    /* The committed record, from its first chunk to the next header */
+    kept = 0;
+    if (0 != _commit_cxt.header.dataLength)
     {
-        FWL_TAG_INFO("[saveHeader] Data buffer NULL");
+        first_addr = _commit_cxt.header.addr;
+        if (MEMORY_HEADER_LARGE_TYPE == _commit_cxt.header.type)
+        {
+            mem_cxt = _commit_cxt;
+            mem_cxt.data.pBuffer = (uint8_t *)&large;
+            mem_cxt.data.length = mem_cxt.header.dataLength;
+            if ((sizeof(large_cxt_t) != mem_cxt.data.length) || !loadData(&mem_cxt))
+            {
+                FWL_TAG_INFO("[writeLarge] commit failed!");
+                return false;
+            }
+            first_addr = large.firstAddr;
+        }
+
+        kept = _memory_cxt.header.nextAddr - first_addr;
+        if (_memory_cxt.header.nextAddr < first_addr)
+        {
+            kept += _memory_size;
+        }
+    }
+
+    /* All chunks must be available until commit, includes reset address */
+    chunk_cnt = (length + MEMORY_LENGTH_MAX - 1) / MEMORY_LENGTH_MAX;
+    span = chunk_cnt * _header2data_offset_length + length + _header2data_offset_length + sizeof(large_cxt_t);
+    if (((uint64_t)kept + span + _page_erase_size + _header2data_offset_length + MEMORY_LENGTH_MAX) > _memory_size)
+    {
+        FWL_TAG_INFO("[writeLarge] memory size is not enough, length %u", length);
         return false;
     }
 
-    if ((mem->data.length > MEMORY_LENGTH_MAX) || (0 == mem->data.length))
+    memory_cxt_t w_memory = _memory_cxt;
+    w_memory.header.type = MEMORY_HEADER_CHUNK_TYPE;
+    for (offset = 0; offset < length; offset += w_memory.data.length)
     {
-        FWL_TAG_INFO("[saveHeader] Data length failed!");
+        w_memory.data.pBuffer = buff + offset;
+        w_memory.data.length = length - offset;
+        if (w_memory.data.length > MEMORY_LENGTH_MAX)
+        {
+            w_memory.data.length = MEMORY_LENGTH_MAX;
+        }
+
+        if (!saveData(&w_memory))
+        {
+            FWL_TAG_INFO("[writeLarge] chunk at %u failed!", offset);
+            return false;
+        }
+        _memory_cxt = w_memory;
+
+        if (0 == offset)
+        {
+            large.firstAddr = w_memory.header.addr;
+        }
+    }
+
+    /* Commit */
+    large.length = length;
+    w_memory.data.pBuffer = (uint8_t *)&large;
+    w_memory.data.length = sizeof(large_cxt_t);
+    w_memory.header.type = MEMORY_HEADER_LARGE_TYPE;
+    if (!saveData(&w_memory))
+    {
+        FWL_TAG_INFO("[writeLarge] commit failed!");
         return false;
     }
+    _memory_cxt = w_memory;
+    _commit_cxt = w_memory;
 
-    /* Make header prev address */
-    mem->header.prevAddr = temp.header.addr;
-    /* Make header address */
-    mem->header.addr = temp.header.nextAddr;
-    /* Make header next address */
-    mem->header.nextAddr = temp.header.nextAddr;
-    mem->header.nextAddr += _header2data_offset_length;
-    mem->header.nextAddr += temp.data.length;
-    /* the space remain memory is not enough fill data */
-    if (mem->header.nextAddr > (_start_addr + _memory_size))
+    FWL_TAG_INFO("[writeLarge] %u byte, %u chunks", length, chunk_cnt);
+    return true;
+} // writeLarge
+
+/**
+ * @brief Read the chunks of the committed large data, each chunk is streamed
+ *        to the buffer and verified by CRC32.
+ * @param [in] buff The buffer data read from flash.
+ * @param [in, out] length The length of buffer read from flash.
+ */
+bool FlashWearLevellingUtils::readLarge(uint8_t *buff, uint32_t *length)
+{
+    large_cxt_t large;
+    memory_cxt_t mem_cxt;
+    uint32_t offset, prev_addr, remain_length;
+
+    _commit_cxt.data.pBuffer = (uint8_t *)&large;
+    _commit_cxt.data.length = _commit_cxt.header.dataLength;
+    if ((sizeof(large_cxt_t) != _commit_cxt.data.length) || !loadData(&_commit_cxt))
     {
-        FWL_TAG_INFO("[saveHeader] Reset address");
-        /* Reset address header base equal _start_addr */
-        mem->header.addr = _start_addr;
-        /* Make header next address again */
-        mem->header.nextAddr = _start_addr;
-        mem->header.nextAddr += _header2data_offset_length;
-        mem->header.nextAddr += temp.data.length;
+        FWL_TAG_INFO("[readLarge] commit failed!");
+        return false;
+    }
 
-        /* Reset temp header address */
-        temp.header.nextAddr = _start_addr;
+    if ((*length) < large.length)
+    {
+        FWL_TAG_INFO("[readLarge] length buffer is not enough!");
+        return false;
+    }
 
-        /* Erase first page */
-        FWL_TAG_INFO("[saveHeader] erase first page");
-        if (!_pCallbacks->onErase(_start_addr, _page_erase_size))
+    mem_cxt.header.addr = large.firstAddr;
+    prev_addr = MEMORY_HEADER_END;
+    for (offset = 0; offset < large.length; offset += mem_cxt.data.length)
+    {
+        if (!loadHeader(&mem_cxt) || (MEMORY_HEADER_CHUNK_TYPE != mem_cxt.header.type))
         {
-            FWL_TAG_INFO("[saveHeader] erase failed!");
+            FWL_TAG_INFO("[readLarge] chunk header failed!");
+            return false;
+        }
+
+        if ((MEMORY_HEADER_END != prev_addr) && (mem_cxt.header.prevAddr != prev_addr))
+        {
+            FWL_TAG_INFO("[readLarge] chunk link failed!");
+            return false;
+        }
+
+        if ((offset + mem_cxt.header.dataLength) > large.length)
+        {
+            FWL_TAG_INFO("[readLarge] chunk length failed!");
+            return false;
+        }
+
+        mem_cxt.data.pBuffer = buff + offset;
+        mem_cxt.data.length = mem_cxt.header.dataLength;
+        mem_cxt.data.addr = mem_cxt.header.addr + _header2data_offset_length;
+        if (!loadData(&mem_cxt))
+        {
+            FWL_TAG_INFO("[readLarge] chunk data failed!");
             return false;
         }
+
+        /* Same rule with saveHeader(), reset address if the next chunk is not fit */
+        prev_addr = mem_cxt.header.addr;
+        mem_cxt.header.addr = mem_cxt.header.nextAddr;
+        remain_length = large.length - offset - mem_cxt.data.length;
+        if (remain_length > MEMORY_LENGTH_MAX)
+        {
+            remain_length = MEMORY_LENGTH_MAX;
+        }
+        if ((mem_cxt.header.nextAddr + _header2data_offset_length + remain_length) > (_start_addr + _memory_size))
+        {
+            mem_cxt.header.addr = _start_addr;
+        }
     }
-    /* Make header data length */
-    mem->header.dataLength = temp.data.length;
-    /* Make header type */
-    mem->header.type = MEMORY_HEADER_TYPE;
-    /* Make data address */
-    mem->data.addr = temp.header.nextAddr + _header2data_offset_length;
-    /* Make CRC */
-    mem->header.crc32 = fwl_header_crc32(mem);
 
-#if (1)
-    FWL_TAG_INFO("[saveHeader] header.crc32 0x%X", mem->header.crc32);
-    FWL_TAG_INFO("[saveHeader] header.nextAddr %u(0x%X)", mem->header.nextAddr, mem->header.nextAddr);
-    FWL_TAG_INFO("[saveHeader] header.addr %u(0x%X)", mem->header.addr, mem->header.addr);
-    FWL_TAG_INFO("[saveHeader] header.prevAddr %u(0x%X)", mem->header.prevAddr, mem->header.prevAddr);
-    FWL_TAG_INFO("[saveHeader] header.dataLength %u", mem->header.dataLength);
-#endif
+    /* The last chunk is linked to the commit record */
+    if (prev_addr != _commit_cxt.header.prevAddr)
+    {
+        FWL_TAG_INFO("[readLarge] commit link failed!");
+        return false;
+    }
 
-    uint16_t length = _header2data_offset_length;
-    if (!submitData(mem->header.addr, (uint8_t *)&mem->header.crc32, &length))
+    *length = large.length;
+    return true;
+} // readLarge
+
+/**
+ * @brief Compress data into _pCompress: original length (2-byte) + RLE stream.
+ * @return The compressed length, 0 if it is not shorter than the data.
+ */
+uint32_t FlashWearLevellingUtils::compressData(uint8_t *buff, uint32_t length)
+{
+    uint32_t encode_length;
+
+    if (length <= (MEMORY_RLE_PREFIX_LENGTH + 1U))
     {
-        FWL_TAG_INFO("[saveHeader] Write Data failed!");
+        return 0;
+    }
+
+    encode_length = RLE_Encode(buff, length, _pCompress + MEMORY_RLE_PREFIX_LENGTH,
+                               length - MEMORY_RLE_PREFIX_LENGTH - 1U);
+    if (0 == encode_length)
+    {
+        return 0;
+    }
+
+    _pCompress[0] = (uint8_t)(length & 0xFF);
+    _pCompress[1] = (uint8_t)(length >> 8);
+    return MEMORY_RLE_PREFIX_LENGTH + encode_length;
+} // compressData
+
+/**
+ * @brief Decode the data of a MEMORY_HEADER_RLE_TYPE record.
+ * @param [in] src The data of record.
+ * @param [in] src_length The length of data of record.
+ * @param [out] buff The buffer of original data.
+ * @param [inout] length The size of buffer, the original length.
+ */
+bool FlashWearLevellingUtils::expandData(const uint8_t *src, uint32_t src_length, uint8_t *buff, uint32_t *length)
+{
+    uint32_t original_length;
+
+    if (src_length <= MEMORY_RLE_PREFIX_LENGTH)
+    {
+        FWL_TAG_INFO("[expandData] length failed!");
         return false;
     }
 
-    if (length != _header2data_offset_length)
+    original_length = src[0] | ((uint32_t)src[1] << 8);
+    if ((*length) < original_length)
     {
-        FWL_TAG_INFO("[saveHeader] Write length failed!");
+        FWL_TAG_INFO("[expandData] length buffer is not enough!");
+        return false;
+    }
+
+    if (RLE_Decode(src + MEMORY_RLE_PREFIX_LENGTH, src_length - MEMORY_RLE_PREFIX_LENGTH, buff, original_length) != original_length)
+    {
+        FWL_TAG_INFO("[expandData] decode failed!");
+        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_SIZE_DATA);
         return false;
     }
 
+    *length = original_length;
     return true;
-} // saveHeader
+} // expandData
 
 /**
- * @brief verify header header information.
- * @param [in] memory_cxt_t The structure content variable informations.
+ * @brief Load and decode a MEMORY_HEADER_RLE_TYPE record.
  */
-bool FlashWearLevellingUtils::verifyHeader(memory_cxt_t *mem)
+bool FlashWearLevellingUtils::readCompressed(memory_cxt_t *mem, uint8_t *buff, uint32_t *length)
 {
-    if (0xFFFFFFFF == mem->header.crc32)
+    bool status_isOK;
+
+    /* The compression can be disabled after the record was written */
+    uint8_t *ptr_data = _pCompress;
+    if (ptr_data == nullptr)
     {
-        FWL_TAG_INFO("[verifyHeader] Header CRC32 failed!");
-        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_HEADER);
-        return false;
+        ptr_data = scratchAlloc(MEMORY_LENGTH_MAX);
+        if (ptr_data == nullptr)
+        {
+            FWL_TAG_INFO("[readCompressed] Allocate RAM failed!");
+            return false;
+        }
     }
 
-    if (mem->header.type != MEMORY_HEADER_TYPE)
+    mem->data.pBuffer = ptr_data;
+    mem->data.length = mem->header.dataLength;
+    status_isOK = loadData(mem) && expandData(ptr_data, mem->data.length, buff, length);
+    if (!status_isOK)
     {
-        FWL_TAG_INFO("[verifyHeader] Header type failed!");
-        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_TYPE_HEADER);
+        FWL_TAG_INFO("[readCompressed] Data failed!");
+    }
+
+    if (ptr_data != _pCompress)
+    {
+        scratchFree(ptr_data); /* free memory */
+    }
+
+    return status_isOK;
+} // readCompressed
+
+/**
+ * @brief Load a MEMORY_HEADER_INTENT_TYPE record, the transaction id is removed.
+ */
+bool FlashWearLevellingUtils::readIntent(memory_cxt_t *mem, uint8_t *buff, uint32_t *length)
+{
+    bool status_isOK;
+
+    if (((*length) + MEMORY_TXN_ID_LENGTH) < mem->header.dataLength)
+    {
+        FWL_TAG_INFO("[readIntent] length buffer is not enough!");
         return false;
     }
 
-    if ((mem->header.dataLength > MEMORY_LENGTH_MAX) || (0 == mem->header.dataLength))
+    uint8_t *ptr_data = scratchAlloc(MEMORY_LENGTH_MAX);
+    if (ptr_data == nullptr)
     {
-        FWL_TAG_INFO("[verifyHeader] Header length failed!");
-        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_SIZE_HEADER);
+        FWL_TAG_INFO("[readIntent] Allocate RAM failed!");
         return false;
     }
 
-    if ((mem->header.nextAddr != MEMORY_HEADER_END) && (mem->header.nextAddr > (_start_addr + _memory_size)))
+    mem->data.pBuffer = ptr_data;
+    mem->data.length = mem->header.dataLength;
+    status_isOK = loadData(mem) && (mem->data.length > MEMORY_TXN_ID_LENGTH);
+    if (status_isOK)
+    {
+        *length = mem->data.length - MEMORY_TXN_ID_LENGTH;
+        memcpy(buff, ptr_data + MEMORY_TXN_ID_LENGTH, *length);
+    }
+    else
+    {
+        FWL_TAG_INFO("[readIntent] Data failed!");
+    }
+
+    scratchFree(ptr_data); /* free memory */
+    return status_isOK;
+} // readIntent
+
+/**
+ * @brief history visitor, keep the newest committed record.
+ */
+bool FlashWearLevellingUtils::commitRecord(const memory_cxt_t *mem)
+{
+    _commit_cxt = *mem;
+    return false;
+} // commitRecord
+
+/**
+ * @brief The lowest address of a record from previous round can be still available,
+ *        the pages before it were erased by the current round.
+ */
+uint32_t FlashWearLevellingUtils::historyBoundary()
+{
+    uint32_t boundary;
+
+    /* The page of next header was erased, even it start at the begin of page */
+    boundary = _memory_cxt.header.nextAddr - _start_addr;
+    boundary = _start_addr + (boundary / _page_erase_size + 1) * _page_erase_size;
+    if (boundary > (_start_addr + _memory_size))
     {
-        FWL_TAG_INFO("[verifyHeader] Header nextAddr failed!");
-        return false;
+        boundary = _start_addr + _memory_size;
     }
 
-    return true;
-} // verifyHeader
+    return boundary;
+} // historyBoundary
 
 /**
- * @brief Get data from header information.
- * @param [in] memory_cxt_t The structure content variable informations.
+ * @brief Address of the record written k writes ago in fixed data length mode.
+ *        All records have the same size, a round reset address to _start_addr
+ *        at the same record index.
+ * @return MEMORY_HEADER_END if the record is not available.
  */
-bool FlashWearLevellingUtils::loadData(memory_cxt_t *mem)
+uint32_t FlashWearLevellingUtils::fixedRecordAddr(uint32_t k)
 {
-    FWL_TAG_INFO("[loadData] verifyHeader");
-    if (!verifyHeader(mem))
-    {
-        FWL_TAG_INFO("[loadData] header failed!");
-        return false;
-    }
+    uint32_t record_size, record_index, record_cnt, addr;
 
-    if (mem->data.pBuffer == NULL)
+    record_size = _header2data_offset_length + _data_length;
+    if ((_memory_cxt.header.dataLength != _data_length)
+        || ((_memory_cxt.header.addr - _start_addr) % record_size))
     {
-        FWL_TAG_INFO("[loadData] Data buffer NULL");
-        return false;
+        FWL_TAG_INFO("[fixedRecordAddr] not fixed data length mode!");
+        return MEMORY_HEADER_END;
     }
 
-    if ((mem->data.length > MEMORY_LENGTH_MAX) || (0 == mem->data.length))
+    record_index = (_memory_cxt.header.addr - _start_addr) / record_size;
+    if (k <= record_index)
     {
-        FWL_TAG_INFO("[loadData] Data length failed!");
-        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_SIZE_DATA);
-        return false;
+        return _start_addr + (record_index - k) * record_size;
     }
 
-    /* Get data */
-    if (!_pCallbacks->onRead(mem->data.addr, mem->data.pBuffer, &mem->data.length))
+    /* The record in previous round */
+    record_cnt = _memory_size / record_size;
+    if ((k - record_index) > record_cnt)
     {
-        FWL_TAG_INFO("[loadData] Read Data failed!");
-        return false;
+        return MEMORY_HEADER_END;
     }
 
-    if (mem->data.length != mem->header.dataLength)
+    addr = _start_addr + (record_cnt - (k - record_index)) * record_size;
+    if (addr < historyBoundary())
     {
-        FWL_TAG_INFO("[loadData] Read length failed!");
-        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_READ_DATA);
-        return false;
+        return MEMORY_HEADER_END;
     }
 
-    /* Checksum */
-    FWL_TAG_INFO("[loadData] fwl_header_crc32");
-    if (fwl_header_crc32(mem) != mem->header.crc32)
+    return addr;
+} // fixedRecordAddr
+
+/**
+ * @brief The first record of the current round is linked to the previous round.
+ */
+bool FlashWearLevellingUtils::fixedRecordWrapped()
+{
+    memory_cxt_t mem_cxt;
+
+    mem_cxt.header.addr = _start_addr;
+    if (!loadHeader(&mem_cxt))
     {
-        FWL_TAG_INFO("[loadData] CRC32 header failed!");
-        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_CRC_DATA);
         return false;
     }
 
-#if (1)
-    FWL_TAG_INFO("[loadData] addr %u(0x%x)", mem->data.addr, mem->data.addr);
-    FWL_TAG_INFO("[loadData] length %u", mem->data.length);
-    FWL_TAG_INFO("[loadData] CRC32 succeed!");
-#endif
-
-    return true;
-} // loadData
+    return (mem_cxt.header.prevAddr != _start_addr);
+} // fixedRecordWrapped
 
 /**
- * @brief set data from header information.
- * @param [in] memory_cxt_t The structure content variable informations.
+ * @brief Make sure the memory range is available in the prefetch window.
+ * @param [in] win The prefetch window.
+ * @param [in] addr The address begin of range.
+ * @param [in] length The length of range.
+ * @param [in] backward The window is filled toward lower address.
  */
-bool FlashWearLevellingUtils::saveData(memory_cxt_t *mem)
+bool FlashWearLevellingUtils::prefetch(prefetch_cxt_t *win, uint32_t addr, uint32_t length, bool backward)
 {
-    FWL_TAG_INFO("[saveData] save header");
-    if (!saveHeader(mem))
-    {
-        FWL_TAG_INFO("[saveData] header failed!");
-        return false;
-    }
+    uint32_t win_start, win_end;
+    uint32_t read_length;
 
-    /* write data */
-    FWL_TAG_INFO("[saveData] save data");
-    if (!submitData(mem->data.addr, mem->data.pBuffer, &mem->data.length))
+    if ((addr < _start_addr) || ((addr + length) > (_start_addr + _memory_size)) || (length > win->size))
     {
-        FWL_TAG_INFO("[saveData] Write Data failed!");
+        FWL_TAG_INFO("[prefetch] range failed!");
         return false;
     }
 
-    if (mem->data.length != mem->header.dataLength)
+    /* Hit */
+    if ((addr >= win->addr) && ((addr + length) <= (win->addr + win->length)))
     {
-        FWL_TAG_INFO("[saveData] Write length failed!");
-        _pCallbacks->onStatus(FlashWearLevellingCallbacks::status_t::ERROR_WRITE_DATA);
-        return false;
+        return true;
     }
 
-    /* Erase CRC next header */
-#if (0) /* Not need, because The flash must be erase before write anything */
-    if ((mem->header.nextAddr + 4) <= (_start_addr + _memory_size))
+    if (backward)
     {
-        uint8_t buff[4] = {0xFF, 0xFF, 0xFF, 0xFF};
-        uint16_t length = 4;
-
-        if (!submitData(mem->header.nextAddr, buff, &length))
+        /* Keep a whole record at addr and as many as previous records */
+        win_end = addr + _header2data_offset_length + MEMORY_LENGTH_MAX;
+        if (win_end < (addr + length))
         {
-            FWL_TAG_INFO("[saveData] Erase CRC failed!");
-            return false;
+            win_end = addr + length;
         }
-        if (length != 4)
+        if (win_end > (_start_addr + _memory_size))
         {
-            FWL_TAG_INFO("[saveData] Erase CRC length failed!");
-            return false;
+            win_end = _start_addr + _memory_size;
+        }
+        win_start = (win_end - _start_addr > win->size) ? (win_end - win->size) : _start_addr;
+    }
+    else
+    {
+        win_start = addr;
+        win_end = addr + win->size;
+        if (win_end > (_start_addr + _memory_size))
+        {
+            win_end = _start_addr + _memory_size;
         }
     }
-#endif
 
-#if (1)
-    FWL_TAG_INFO("[saveData] addr %u(0x%x)", mem->data.addr, mem->data.addr);
-    FWL_TAG_INFO("[saveData] length %u", mem->data.length);
-    FWL_TAG_INFO("[saveData] succeed");
-#endif
+    read_length = win_end - win_start;
+    FWL_TAG_INFO("[prefetch] addr %u(0x%X) length %u", win_start, win_start, read_length);
+    win->length = 0;
+    if (!_pCallbacks->onRead(win_start, win->pBuffer, &read_length))
+    {
+        FWL_TAG_INFO("[prefetch] Read failed!");
+        return false;
+    }
+
+    if (read_length != (win_end - win_start))
+    {
+        FWL_TAG_INFO("[prefetch] Read length failed!");
+        return false;
+    }
+
+    win->addr = win_start;
+    win->length = read_length;
 
     return true;
-} // saveData
+} // prefetch
 
 /**
- * @brief writeout data.
- * @param [in] addr The address write into flash.
- * @param [in] buff The buffer data write into flash.
- * @param [in] length The length of buffer write into flash.
+ * @brief Get header and data of a record through the prefetch window,
+ *        the data buffer point into the window and CRC32 is not verified.
+ * @param [in] win The prefetch window.
+ * @param [in] addr The address of header.
+ * @param [out] memory_cxt_t The structure content variable informations.
+ * @param [in] backward The window is filled toward lower address.
  */
-bool FlashWearLevellingUtils::submitData(uint32_t addr, uint8_t *buff, uint16_t *length)
+bool FlashWearLevellingUtils::prefetchRecord(prefetch_cxt_t *win, uint32_t addr, memory_cxt_t *mem, bool backward)
 {
-    if (!eraseData(addr, *length))
+    if (!prefetch(win, addr, _header2data_offset_length, backward))
     {
-        FWL_TAG_INFO("[submitData] erase failed!");
         return false;
     }
 
-    if (!_pCallbacks->onWrite(addr, buff, length))
+    mem->header.addr = addr;
+    memcpy(&mem->header.crc32, win->pBuffer + (addr - win->addr), _header2data_offset_length);
+    if (!checkHeader(mem))
+    {
+        return false;
+    }
+
+    mem->data.addr = addr + _header2data_offset_length;
+    mem->data.length = mem->header.dataLength;
+    if (!prefetch(win, mem->data.addr, mem->data.length, backward))
     {
-        FWL_TAG_INFO("[submitData] write failed!");
         return false;
     }
+    mem->data.pBuffer = win->pBuffer + (mem->data.addr - win->addr);
 
     return true;
-} // submitData
+} // prefetchRecord
 
 /**
- * @brief erase data from header information.
- * @param [in] memory_cxt_t The structure content variable informations.
+ * @brief Step to the previous record of chain.
+ * @param [in] win The prefetch window.
+ * @param [in, out] memory_cxt_t The current record, update to the previous record.
+ * @param [in, out] wrapped The chain is moved to the previous round.
+ * @param [in] boundary The result of historyBoundary().
  */
-bool FlashWearLevellingUtils::eraseData(uint32_t addr, uint16_t length)
+bool FlashWearLevellingUtils::historyPrev(prefetch_cxt_t *win, memory_cxt_t *mem, bool *wrapped, uint32_t boundary)
 {
-    uint32_t offset_addr, remain_size, erase_addr, page_erase_cnt;
-    bool status_isOK = true;
-
-    offset_addr = addr % _page_erase_size;
-    remain_size = _page_erase_size - offset_addr;
-    erase_addr = addr + remain_size;
+    memory_cxt_t prev;
+    uint32_t prev_addr = mem->header.prevAddr;
 
-    FWL_TAG_INFO("[eraseData] addr in: %u(0x%x)", addr, addr);
-    FWL_TAG_INFO("[eraseData] length in: %u", length);
-    FWL_TAG_INFO("[eraseData] remain_size: %u", remain_size);
-
-    /* Write data with write_length 
-        uint32_t write_length;
-        if (length >= remain_size)
-        {
-            write_length = remain_size;
-        }
-        else
-        {
-            write_length = length;
-        }
-        _pCallbacks->onWrite(addr, buff, write_length);
-    */
-    page_erase_cnt = 0;
-    while (length >= remain_size)
+    /* The first record since format */
+    if (prev_addr == mem->header.addr)
     {
-        FWL_TAG_INFO("[eraseData] erase_addr: %u", erase_addr);
-
-        if (erase_addr == (_start_addr + _memory_size) && (length == remain_size))
-        {
-            FWL_TAG_INFO("[eraseData] last page");
-            break;
-        }
-
-        /* Assert memory size */
-        if ((erase_addr + _page_erase_size) > (_start_addr + _memory_size))
-        {
-            FWL_TAG_INFO("[eraseData] addr failed!");
-            status_isOK = false;
-            break;
-        }
+        return false;
+    }
 
-        /* Erase next page */
-        if (!_pCallbacks->onErase(erase_addr, _page_erase_size))
+    if (prev_addr > mem->header.addr)
+    {
+        /* Only one round is kept in memory */
+        if (*wrapped)
         {
-            FWL_TAG_INFO("[eraseData] erase failed!");
-            status_isOK = false;
-            break;
+            return false;
         }
+        *wrapped = true;
+    }
 
-        ++page_erase_cnt;
-
-        /* Remain Length */
-        length -= remain_size;
-        /* Write data with write_length
-            if (length >= _page_erase_size)
-            {
-                write_length = _page_erase_size;
-            }
-            else
-            {
-                write_length = length;
-            }
-
-            if(write_length > 0)
-            {
-                _pCallbacks->onWrite(erase_addr, buff, write_length);
-            }
-        */
-
-        /* new remain size is equal page size */
-        remain_size = _page_erase_size;
-
-        /* update address to erase next page */
-        erase_addr += _page_erase_size;
-
-        FWL_TAG_INFO("[eraseData] remain length: %u", length);
-        FWL_TAG_INFO("[eraseData] remain_size: %u", remain_size);
-    } // while (length >= remain_size)
+    /* The record of previous round was erased */
+    if (*wrapped && (prev_addr < boundary))
+    {
+        return false;
+    }
 
-    if (page_erase_cnt > 0)
+    if (!prefetchRecord(win, prev_addr, &prev, true))
     {
-        FWL_TAG_INFO("[eraseData] page number is erased: %u", page_erase_cnt);
+        return false;
     }
-    else
+
+    /* The record at the end of previous round have no link to the start address */
+    if ((prev.header.nextAddr != mem->header.addr) && (mem->header.addr != _start_addr))
     {
-        FWL_TAG_INFO("[eraseData] No");
+        FWL_TAG_INFO("[historyPrev] link failed!");
+        return false;
     }
 
-    return status_isOK;
-} // eraseData
+    *mem = prev;
+    return true;
+} // historyPrev
 
 /**
- * verify memory information
-*/
-bool FlashWearLevellingUtils::verifyMemInfo()
+ * @brief Step to the next record of chain.
+ * @param [in] win The prefetch window.
+ * @param [in, out] memory_cxt_t The current record, update to the next record.
+ */
+bool FlashWearLevellingUtils::historyNext(prefetch_cxt_t *win, memory_cxt_t *mem)
 {
-    if ((_start_addr % _page_erase_size))
-    {
-        FWL_TAG_INFO("[verifyMemInfo][error] _start_addr must be multiples _page_erase_size");
-        return false;
-    }
+    memory_cxt_t next;
+    uint32_t next_addr = mem->header.nextAddr;
 
-    if ((0 == _memory_size) || (_memory_size % _page_erase_size))
+    if ((next_addr + _header2data_offset_length) <= (_start_addr + _memory_size)
+        && prefetchRecord(win, next_addr, &next, false)
+        && (next.header.prevAddr == mem->header.addr))
     {
-        FWL_TAG_INFO("[verifyMemInfo][error] _memory_size must be multiples _page_erase_size");
-        return false;
+        *mem = next;
+        return true;
     }
 
-    if ((_data_length + _header2data_offset_length) > _memory_size)
+    /* The next record was reset address to the start address */
+    if (prefetchRecord(win, _start_addr, &next, false)
+        && (next.header.prevAddr == mem->header.addr))
     {
-        FWL_TAG_INFO("[verifyMemInfo][error] _memory_size is not enough, min = %u", _data_length + _header2data_offset_length);
-        return false;
+        *mem = next;
+        return true;
     }
 
-    return true;
-} // verifyMemInfo
+    return false;
+} // historyNext
 
 /**
  * The callback handler flash memory
@@ -800,7 +2203,7 @@ FlashWearLevellingCallbacks::~FlashWearLevellingCallbacks() {}
  * @param [in] buff The buffer data write into flash.
  * @param [in] length The length of buffer write into flash.
  */
-bool FlashWearLevellingCallbacks::onRead(uint32_t addr, uint8_t *buff, uint16_t *length)
+bool FlashWearLevellingCallbacks::onRead(uint32_t addr, uint8_t *buff, uint32_t *length)
 {
     FWL_TAG_INFO(">> onRead: default << onRead");
     return true;
@@ -812,7 +2215,7 @@ bool FlashWearLevellingCallbacks::onRead(uint32_t addr, uint8_t *buff, uint16_t
  * @param [in] buff The buffer data write into flash.
  * @param [in] length The length of buffer write into flash.
  */
-bool FlashWearLevellingCallbacks::onWrite(uint32_t addr, uint8_t *buff, uint16_t *length)
+bool FlashWearLevellingCallbacks::onWrite(uint32_t addr, uint8_t *buff, uint32_t *length)
 {
     FWL_TAG_INFO(">> onWrite: default << onWrite");
     return true;
@@ -823,7 +2226,7 @@ bool FlashWearLevellingCallbacks::onWrite(uint32_t addr, uint8_t *buff, uint16_t
  * @param [in] addr The address erase
  * @param [in] length The length of buffer erase
  */
-bool FlashWearLevellingCallbacks::onErase(uint32_t addr, uint16_t length)
+bool FlashWearLevellingCallbacks::onErase(uint32_t addr, uint32_t length)
 {
     FWL_TAG_INFO(">> onErase: default << onErase");
     return true;
@@ -847,4 +2250,96 @@ void FlashWearLevellingCallbacks::onStatus(status_t s)
     FWL_TAG_INFO(">> onStatus: default << onStatus");
 } // onStatus
 
+/**
+ * @brief Callback function to support the factory bad block marker.
+ * @param [in] addr The address of the page erase.
+ */
+bool FlashWearLevellingCallbacks::onBadBlock(uint32_t addr)
+{
+    FWL_TAG_INFO(">> onBadBlock: default << onBadBlock");
+    return false;
+} // onBadBlock
+
+/**
+ * @brief Callback function to support a NAND page program with its spare area.
+ * @param [in] addr The address of the page.
+ * @param [in] buff The data of the page, nullptr if only the spare area is programmed.
+ * @param [in] length The length of data.
+ * @param [in] oob The data of the spare area.
+ * @param [in] oob_length The length of the spare area data.
+ */
+bool FlashWearLevellingCallbacks::onPageProgram(uint32_t addr, uint8_t *buff, uint32_t length, uint8_t *oob, uint32_t oob_length)
+{
+    FWL_TAG_INFO(">> onPageProgram: default << onPageProgram");
+    return false;
+} // onPageProgram
+
+/**
+ * @brief Callback function to support a NAND page read with its spare area.
+ * @param [in] addr The address of the page.
+ * @param [out] buff The data of the page, nullptr if only the spare area is read.
+ * @param [in] length The length of data.
+ * @param [out] oob The data of the spare area.
+ * @param [in] oob_length The length of the spare area data.
+ */
+bool FlashWearLevellingCallbacks::onPageRead(uint32_t addr, uint8_t *buff, uint32_t length, uint8_t *oob, uint32_t oob_length)
+{
+    FWL_TAG_INFO(">> onPageRead: default << onPageRead");
+    return false;
+} // onPageRead
+
+/**
+ * @brief Callback function to advertise the block erase sizes of the memory, e.g. 32KB and 64KB
+ *        of SPI NOR. onErase() is called with these lengths at the aligned addresses.
+ * @return The OR of the erase sizes (powers of 2) larger than the page erase size, 0 if none.
+ */
+uint32_t FlashWearLevellingCallbacks::onEraseSizes()
+{
+    return 0;
+} // onEraseSizes
+
+/**
+ * @brief Callback function to advertise a byte-addressable memory, a write replaces the
+ *        old data without erase. The instances keep the A/B records in place.
+ */
+bool FlashWearLevellingCallbacks::onInPlaceWrite()
+{
+    return false;
+} // onInPlaceWrite
+
+/**
+ * @brief Erase contiguous pages by the largest aligned erase supported by onEraseSizes().
+ * @param [in] addr The address of the first page.
+ * @param [in] length The length to erase, multiples page erase size.
+ * @param [in] page_erase_size The page erase size.
+ */
+bool FlashWearLevellingCallbacks::eraseRange(uint32_t addr, uint32_t length, uint32_t page_erase_size)
+{
+    uint32_t sizes = onEraseSizes();
+    uint32_t size, erase_size;
+
+    while (length > 0)
+    {
+        erase_size = (length < page_erase_size) ? length : page_erase_size;
+        for (size = 0x80000000U; sizes && (size > page_erase_size); size >>= 1)
+        {
+            if ((sizes & size) && (0 == (addr % size)) && (length >= size))
+            {
+                erase_size = size;
+                break;
+            }
+        }
+
+        if (!onErase(addr, erase_size))
+        {
+            return false;
+        }
+
+        addr += erase_size;
+        length -= erase_size;
+    }
+
+    return true;
+} // eraseRange
+
 FlashWearLevellingCallbacks defaultCallback; //null-object-pattern
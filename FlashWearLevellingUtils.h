@@ -22,9 +22,13 @@
 #include <array>
 #include <string>
 #include "console_dbg.h"
+#include "FlashSerializer.h"
 
 #define MEMORY_SIZE_DEFAULT 4096U /* 4KB */
 #define PAGE_ERASE_SIZE_DEFAULT 4096U /* 4096-Byte */
+#ifndef HISTORY_PREFETCH_SIZE_DEFAULT
+#define HISTORY_PREFETCH_SIZE_DEFAULT 512U /* 512-Byte, must fit header + MEMORY_LENGTH_MAX */
+#endif
 
 #define FWL_TAG_INFO(...) //CONSOLE_TAG_LOGI("[FWL]", __VA_ARGS__)
 #define FWL_INFO(...) //CONSOLE_LOGI(__VA_ARGS__)
@@ -35,7 +39,7 @@ typedef struct __attribute__((packed, aligned(4)))
     {
         uint8_t *pBuffer;
         uint32_t addr;
-        uint16_t length;
+        uint32_t length;
     } data;
 
     struct
@@ -51,6 +55,23 @@ typedef struct __attribute__((packed, aligned(4)))
     } header;
 } memory_cxt_t;
 
+typedef struct
+{
+    uint8_t *pBuffer;
+    uint32_t addr;
+    uint32_t length;
+    uint32_t size;
+} prefetch_cxt_t;
+
+/* The counters since the instance is constructed or resetStats() */
+typedef struct
+{
+    uint32_t recordsWritten;  /* the records programmed, includes chunks and commits */
+    uint32_t payloadBytes;    /* the data of write() */
+    uint32_t bytesProgrammed; /* the headers and the data programmed */
+    uint32_t pagesErased;
+} wear_stats_t;
+
 class FlashWearLevellingCallbacks
 {
 private:
@@ -83,11 +104,22 @@ public:
     }
 
     virtual ~FlashWearLevellingCallbacks();
-    virtual bool onRead(uint32_t addr, uint8_t *buff, uint16_t *length);
-    virtual bool onWrite(uint32_t addr, uint8_t *buff, uint16_t *length);
-    virtual bool onErase(uint32_t addr, uint16_t length);
+    virtual bool onRead(uint32_t addr, uint8_t *buff, uint32_t *length);
+    virtual bool onWrite(uint32_t addr, uint8_t *buff, uint32_t *length);
+    virtual bool onErase(uint32_t addr, uint32_t length);
     virtual bool onReady();
     virtual void onStatus(status_t s);
+    /* The block of addr is marked bad by the factory (NAND) */
+    virtual bool onBadBlock(uint32_t addr);
+    /* NAND page program once, the data and the spare area (oob) of a page. buff is nullptr to program only the spare area */
+    virtual bool onPageProgram(uint32_t addr, uint8_t *buff, uint32_t length, uint8_t *oob, uint32_t oob_length);
+    /* buff is nullptr to read only the spare area */
+    virtual bool onPageRead(uint32_t addr, uint8_t *buff, uint32_t length, uint8_t *oob, uint32_t oob_length);
+    /* The block erase sizes supported, the OR of powers of 2 */
+    virtual uint32_t onEraseSizes();
+    /* The memory is rewritten in place without erase (FRAM, MRAM, EEPROM) */
+    virtual bool onInPlaceWrite();
+    bool eraseRange(uint32_t addr, uint32_t length, uint32_t page_erase_size);
     std::string reportStr(status_t s)
     {
         return _statusStr[s];
@@ -98,13 +130,37 @@ extern FlashWearLevellingCallbacks defaultCallback;
 
 class FlashWearLevellingUtils
 {
+    friend class FlashTransaction;
+
+protected:
     typedef enum
     {
         MEMORY_HEADER_TYPE = 0xAA55,
+        MEMORY_HEADER_CHUNK_TYPE = 0xAA56, /* a part of large data, not committed */
+        MEMORY_HEADER_LARGE_TYPE = 0xAA57, /* commit the chunks of large data */
+        MEMORY_HEADER_RLE_TYPE = 0xAA58,   /* the data is original length (2-byte) + RLE stream */
+        MEMORY_RLE_PREFIX_LENGTH = 2,
+        MEMORY_HEADER_INTENT_TYPE = 0xAA59, /* the data is transaction id (4-byte) + data */
+        MEMORY_TXN_ID_LENGTH = 4,
         MEMORY_LENGTH_MAX = 256,
+        MEMORY_HEADER_LENGTH = 16, /* crc32, nextAddr, prevAddr, dataLength and type */
         MEMORY_HEADER_END = 0xFFFFFFFF
     } memoryType_t;
 
+    typedef struct
+    {
+        uint8_t *pBuffer;
+        uint32_t size;
+        bool isBusy;
+    } scratch_cxt_t;
+
+    /* The data of MEMORY_HEADER_LARGE_TYPE record */
+    typedef struct __attribute__((packed))
+    {
+        uint32_t length;
+        uint32_t firstAddr;
+    } large_cxt_t;
+
 public:
     FlashWearLevellingUtils(uint32_t start_addr = 0, 
                             size_t memory_size = MEMORY_SIZE_DEFAULT, 
@@ -114,14 +170,43 @@ public:
     void setCallbacks(FlashWearLevellingCallbacks *pCallbacks);
     bool begin(bool formatOnFail = false);
     bool format();
-    bool write(uint8_t *buff, uint16_t *length);
-    bool read(uint8_t *buff, uint16_t *length);
+    bool write(uint8_t *buff, uint32_t *length);
+    bool read(uint8_t *buff, uint32_t *length);
     memory_cxt_t info();
+    wear_stats_t stats();
+    void resetStats();
+    /* bytes programmed per payload byte, 0 if no data is written */
+    float writeAmplification();
+    /* The remaining time at the current rate, in the unit of elapsed. eraseCount is
+        the current erase count of the most worn page if it is known, e.g. by FlashPartitionManager */
+    uint32_t lifetime(uint32_t endurance, uint32_t elapsed, uint32_t eraseCount = 0);
+    static void setScratch(uint8_t *buff, uint32_t size);
+    /* Stop sharing buff, only if it is the buffer shared now */
+    static void releaseScratch(const uint8_t *buff);
+
+    /* In-place mode, onInPlaceWrite() of the callbacks is true at begin(): the record is rewritten
+        in slot A or B (the halves of the region) without erase and found by 2 headers at mount.
+        history()/readAt()/readRange() and the data longer than MEMORY_LENGTH_MAX are not available */
+    bool inPlace();
+
+    /* Compress the data by RLE if it is shorter, one MEMORY_LENGTH_MAX byte buffer is allocated.
+        The records have not the fixed length, readAt()/readRange() are not available */
+    bool setCompression(bool enable);
+
+    /* Visitor return false to stop walking the history */
+    typedef mbed::Callback<bool(const memory_cxt_t *)> historyVisitor_t;
+    bool history(historyVisitor_t visitor, uint32_t count = UINT32_MAX, bool oldestFirst = false);
+    /* Copy the data of a record visited, a compressed record is decoded */
+    bool recordData(const memory_cxt_t *mem, uint8_t *buff, uint32_t *length);
+
+    /* Fixed data length mode, the record written k writes ago (k = 0 is the newest) */
+    bool readAt(uint32_t k, uint8_t *buff, uint32_t *length);
+    bool readRange(uint32_t k0, uint32_t k1, uint8_t *buff, uint32_t *length);
 
     template <typename varType>
     bool write(varType *data)
     {
-        uint16_t length = sizeof(varType);
+        uint32_t length = sizeof(varType);
         if (write((uint8_t *)data, &length))
         {
             if (length == sizeof(varType))
@@ -136,7 +221,7 @@ public:
     template <typename varType>
     bool read(varType *data)
     {
-        uint16_t length = sizeof(varType);
+        uint32_t length = sizeof(varType);
         if (read((uint8_t *)data, &length))
         {
             if (length == sizeof(varType))
@@ -148,25 +233,121 @@ public:
         return false;
     } // read
 
-private:
+    /* Encode by FlashSerializer<varType>, bufferSize byte of stack is used */
+    template <typename varType, uint32_t bufferSize = MEMORY_LENGTH_MAX>
+    bool writeObject(const varType *data)
+    {
+        uint8_t buff[bufferSize];
+        FlashWriter writer(buff, bufferSize);
+        if (!writer.put(*data))
+        {
+            return false;
+        }
+
+        uint32_t length = writer.length();
+        return write(buff, &length);
+    } // writeObject
+
+    template <typename varType, uint32_t bufferSize = MEMORY_LENGTH_MAX>
+    bool readObject(varType *data)
+    {
+        uint8_t buff[bufferSize];
+        uint32_t length = bufferSize;
+        if (!read(buff, &length))
+        {
+            return false;
+        }
+
+        FlashReader reader(buff, length);
+        return reader.get(data) && reader.isEnd();
+    } // readObject
+
+    template <typename varType>
+    bool readAt(uint32_t k, varType *data)
+    {
+        uint32_t length = sizeof(varType);
+        if (readAt(k, (uint8_t *)data, &length))
+        {
+            if (length == sizeof(varType))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    } // readAt
+
+    /* data must have (k1 - k0) elements, the newest first */
+    template <typename varType>
+    bool readRange(uint32_t k0, uint32_t k1, varType *data)
+    {
+        uint32_t length = (k1 - k0) * sizeof(varType);
+        if (readRange(k0, k1, (uint8_t *)data, &length))
+        {
+            if (length == (k1 - k0) * sizeof(varType))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    } // readRange
+
+protected:
+    static scratch_cxt_t _scratch;
     const uint16_t _data_length;
     const uint8_t _header2data_offset_length;
     size_t _memory_size;
     uint32_t _start_addr;
     memory_cxt_t _memory_cxt;
+    memory_cxt_t _commit_cxt;
     uint16_t _page_erase_size;
     FlashWearLevellingCallbacks *_pCallbacks;
+    uint8_t *_pCompress; /* nullptr if compression is disabled */
+    wear_stats_t _stats;
+    uint32_t *_pErased; /* bitmap of pages erased and not programmed since */
+    bool _memInfo_isOK;
+    bool _inPlace_isAllowed; /* false if the front-end need the history */
+    bool _inPlace_isEnable;
+    static uint8_t *scratchAlloc(uint32_t size);
+    static void scratchFree(uint8_t *buff);
     bool findLastHeader();
+    bool findInPlaceRecord();
+    bool saveInPlace(memory_cxt_t *mem);
+    bool formatInPlace();
+    uint32_t inPlaceAddr(uint8_t slot);
     bool header_isDefault(void);
     void headerDefault(void);
     bool loadHeader(memory_cxt_t *mem);
+    bool checkHeader(memory_cxt_t *mem);
+    bool headerType_isValid(uint16_t type);
     bool saveHeader(memory_cxt_t *mem);
     bool verifyHeader(memory_cxt_t *mem);
     bool loadData(memory_cxt_t *mem);
+    bool verifyData(memory_cxt_t *mem);
     bool saveData(memory_cxt_t *mem);
-    bool eraseData(uint32_t addr, uint16_t length);
-    bool submitData(uint32_t addr, uint8_t *buff, uint16_t *length);
+    bool eraseData(uint32_t addr, uint32_t length);
+    bool eraseRange(uint32_t addr, uint32_t page_cnt);
+    bool pageErased(uint32_t addr);
+    void pageMark(uint32_t addr, uint32_t length, bool erased);
+    bool blankCheck(uint32_t addr, uint32_t length, bool *blank);
+    bool submitData(uint32_t addr, uint8_t *buff, uint32_t *length);
     bool verifyMemInfo();
+    bool checkMemInfo();
+    bool writeLarge(uint8_t *buff, uint32_t length);
+    bool readLarge(uint8_t *buff, uint32_t *length);
+    uint32_t compressData(uint8_t *buff, uint32_t length);
+    bool expandData(const uint8_t *src, uint32_t src_length, uint8_t *buff, uint32_t *length);
+    bool readCompressed(memory_cxt_t *mem, uint8_t *buff, uint32_t *length);
+    bool readIntent(memory_cxt_t *mem, uint8_t *buff, uint32_t *length);
+    bool commitRecord(const memory_cxt_t *mem);
+    uint32_t historyBoundary();
+    uint32_t fixedRecordAddr(uint32_t k);
+    bool fixedRecordWrapped();
+    bool prefetch(prefetch_cxt_t *win, uint32_t addr, uint32_t length, bool backward);
+    bool prefetchRecord(prefetch_cxt_t *win, uint32_t addr, memory_cxt_t *mem, bool backward);
+    bool historyPrev(prefetch_cxt_t *win, memory_cxt_t *mem, bool *wrapped, uint32_t boundary);
+    bool historyNext(prefetch_cxt_t *win, memory_cxt_t *mem);
 };
 
 #endif
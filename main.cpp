@@ -1,6 +1,8 @@
 #include "mbed.h"
 #include "FlashWearLevellingUtils.h"
 #include "console_dbg.h"
+#include "util_crc32.h"
+#include "util_ecc.h"
 
 /* Private macro -------------------------------------------------------------*/
 #define MAIN_TAG_DBG(...) CONSOLE_TAG_LOGI("[MAIN]", __VA_ARGS__)
@@ -29,7 +31,7 @@ public:
         delete[] pbuff; /* free memory */
     }
 
-    bool write(uint32_t addr, uint8_t *buff, uint16_t *length)
+    bool write(uint32_t addr, uint8_t *buff, uint32_t *length)
     {
         if (addr + (*length) > _v_num)
         {
@@ -40,13 +42,13 @@ public:
         return true;
     }
 
-    bool read(uint32_t addr, uint8_t *buff, uint16_t *length)
+    bool read(uint32_t addr, uint8_t *buff, uint32_t *length)
     {
         memcpy(buff, pbuff + addr, *length);
         return true;
     }
 
-    bool erase(uint32_t addr, uint16_t length)
+    bool erase(uint32_t addr, uint32_t length)
     {
         if (addr + length > _v_num)
         {
@@ -62,17 +64,17 @@ v_memory v_testAPI(1024);
 
 /* Register callback handler external flash memory */
 class FlashHandler: public FlashWearLevellingCallbacks {
-    bool onRead(uint32_t addr, uint8_t *buff, uint16_t *length) {
+    bool onRead(uint32_t addr, uint8_t *buff, uint32_t *length) {
         FWL_TAG_CALLBACK("[FlashHandler] onRead data [addr][length]: [%u(0x%x)][%u]", addr, addr, *length);
         return v_testAPI.read(addr, buff, length);
     }
 
-    bool onWrite(uint32_t addr, uint8_t *buff, uint16_t *length) {
+    bool onWrite(uint32_t addr, uint8_t *buff, uint32_t *length) {
         FWL_TAG_CALLBACK("[FlashHandler] onWrite data [addr][length]: [%u(0x%x)][%u]", addr, addr, *length);
         return v_testAPI.write(addr, buff, length);
     }
 
-    bool onErase(uint32_t addr, uint16_t length) {
+    bool onErase(uint32_t addr, uint32_t length) {
         FWL_TAG_CALLBACK("flash onErase [addr][length]: [%u(0x%x)][%u]", addr, addr, length);
         return v_testAPI.erase(addr, length);
     }
@@ -132,6 +134,45 @@ void fwl_testCase()
     }
 }
 
+#if defined(ECC_BENCHMARK)
+/** Benchmark, build with the macro ECC_BENCHMARK ("macros" of mbed_app.json)
+ * Encode/decode throughput of the page ECC (2KB NAND page) compared with CRC32
+*/
+void ecc_benchmark()
+{
+    static uint8_t page[2048];
+    uint8_t code[ECC_LENGTH(sizeof(page))];
+    const int loop = 50;
+    Timer t;
+
+    for (uint32_t i = 0; i < sizeof(page); ++i)
+    {
+        page[i] = (uint8_t)(i * 31U + 7U);
+    }
+
+    t.start();
+    for (int i = 0; i < loop; ++i)
+    {
+        ECC_Calculate(page, sizeof(page), code);
+    }
+    MAIN_TAG_DBG("[ecc] encode %u KB/s", (uint32_t)(loop * 2000000ULL / t.elapsed_time().count()));
+
+    t.reset();
+    for (int i = 0; i < loop; ++i)
+    {
+        ECC_Correct(page, sizeof(page), code);
+    }
+    MAIN_TAG_DBG("[ecc] decode %u KB/s", (uint32_t)(loop * 2000000ULL / t.elapsed_time().count()));
+
+    t.reset();
+    for (int i = 0; i < loop; ++i)
+    {
+        Crc32_CalculateBuffer(page, sizeof(page));
+    }
+    MAIN_TAG_DBG("[crc32] %u KB/s", (uint32_t)(loop * 2000000ULL / t.elapsed_time().count()));
+}
+#endif
+
 // Blinking rate in milliseconds
 #define BLINKING_RATE     500ms
 
@@ -154,6 +195,10 @@ int main()
         MAIN_TAG_DBG("[setup] u32_log begin failed!");
     }
 
+#if defined(ECC_BENCHMARK)
+    ecc_benchmark();
+#endif
+
     while (true) {
         led = !led;
         ThisThread::sleep_for(BLINKING_RATE);
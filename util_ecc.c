@@ -0,0 +1,138 @@
+/** @file util_ecc.c
+ */
+
+/******************************************************************************/
+//  INCLUDE HEADER
+/******************************************************************************/
+#include "util_ecc.h"
+
+/******************************************************************************/
+//  MACRO. DEFINE
+/******************************************************************************/
+/** Only one bit is set */
+#define ECC_SINGLE_BIT(x)                   (((x) != 0) && (0 == ((x) & ((x) - 1))))
+
+/******************************************************************************/
+//  TYPEDEF
+/******************************************************************************/
+
+/******************************************************************************/
+//  VERIABLES
+/******************************************************************************/
+/** The parity of a byte */
+static const uint8_t ECC_PARITY_TABLE[256] = {
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+};
+
+/******************************************************************************/
+//  FUNCTIONS
+/******************************************************************************/
+/**
+ * @brief The code of a block, one table lookup per byte
+ * 
+ * @param buffer[in]    The block
+ * @param length[in]    Length of block, ECC_BLOCK_SIZE at most
+ * @param code[out]     ECC_CODE_LENGTH bytes
+ */
+static void ecc_block(const uint8_t * buffer, uint32_t length, uint8_t * code)
+{
+	uint8_t column = 0, line = 0, line_inv = 0;
+	uint32_t i;
+
+	for (i = 0; i < length; i++)
+	{
+		column ^= buffer[i];
+		if (ECC_PARITY_TABLE[buffer[i]])
+		{
+			line ^= (uint8_t)i;
+			line_inv ^= (uint8_t)~i;
+		}
+	}
+
+	code[0] = column;
+	code[1] = line;
+	code[2] = line_inv;
+}
+
+/**
+ * Calculate the code of a buffer, ECC_LENGTH(length) bytes are written to code
+ */
+void ECC_Calculate(const uint8_t * buffer, uint32_t length, uint8_t * code)
+{
+	uint32_t offset, block;
+
+	for (offset = 0; offset < length; offset += ECC_BLOCK_SIZE)
+	{
+		block = ((length - offset) < ECC_BLOCK_SIZE) ? (length - offset) : ECC_BLOCK_SIZE;
+		ecc_block(buffer + offset, block, code);
+		code += ECC_CODE_LENGTH;
+	}
+}
+
+/**
+ * Correct a buffer by the code read with it, the worst result of blocks is returned
+ */
+ecc_result_t ECC_Correct(uint8_t * buffer, uint32_t length, const uint8_t * code)
+{
+	ecc_result_t result = ECC_OK;
+	uint8_t calc[ECC_CODE_LENGTH], column, line, line_inv;
+	uint32_t offset, block;
+
+	for (offset = 0; offset < length; offset += ECC_BLOCK_SIZE, code += ECC_CODE_LENGTH)
+	{
+		block = ((length - offset) < ECC_BLOCK_SIZE) ? (length - offset) : ECC_BLOCK_SIZE;
+		ecc_block(buffer + offset, block, calc);
+		column = calc[0] ^ code[0];
+		line = calc[1] ^ code[1];
+		line_inv = calc[2] ^ code[2];
+		if ((0 == column) && (0 == line) && (0 == line_inv))
+		{
+			continue;
+		}
+
+		/* A data bit: one bit of column, the line syndromes are inverted each other */
+		if (ECC_SINGLE_BIT(column) && (0xFF == (line ^ line_inv)) && (line < block))
+		{
+			buffer[offset + line] ^= column;
+			if (result < ECC_CORRECTED)
+			{
+				result = ECC_CORRECTED;
+			}
+		}
+		else if ((ECC_SINGLE_BIT(column) && (0 == line) && (0 == line_inv))
+		         || ((0 == column) && ECC_SINGLE_BIT(line) && (0 == line_inv))
+		         || ((0 == column) && (0 == line) && ECC_SINGLE_BIT(line_inv)))
+		{
+			/* One bit of code */
+			if (result < ECC_CODE_ERROR)
+			{
+				result = ECC_CODE_ERROR;
+			}
+		}
+		else
+		{
+			return ECC_UNCORRECTABLE;
+		}
+	}
+
+	return result;
+}
+
+/******************************************************************************/
+//  END
+/******************************************************************************/
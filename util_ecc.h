@@ -0,0 +1,74 @@
+/** @file util_ecc.h
+ *  @brief Table driven Hamming ECC of 256-byte blocks, a single bit error of a
+ *         block is corrected and a double bit error is detected
+ *
+ *  @author tienhuyiot
+ *  @note The code of a block is 3 bytes:
+ *        - byte 0: XOR of all bytes, the bit of an error
+ *        - byte 1: XOR of the index of bytes with odd parity, the byte of an error
+ *        - byte 2: XOR of the inverted index of bytes with odd parity
+ *        A single data bit error give the byte 1 and byte 2 syndromes inverted each other.
+ *  @bug No known bugs.
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who        Date             Changes
+ * -----  --------   ----------       -----------------------------------------------
+ * 1.0    Tienhuyiot Oct 19, 2026     First release
+ *
+ *
+ *</pre>
+ */
+/* MODULE BSP */
+#ifndef __UTIL_ECC_H
+#define __UTIL_ECC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+//  INCLUDE HEADER
+/******************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************/
+//  MACRO. DEFINE
+/******************************************************************************/
+/** The length of a block */
+#define ECC_BLOCK_SIZE                      (256)
+/** The length of code of a block */
+#define ECC_CODE_LENGTH                     (3)
+/** The length of code of a buffer */
+#define ECC_LENGTH(length)                  ((((length) + ECC_BLOCK_SIZE - 1) / ECC_BLOCK_SIZE) * ECC_CODE_LENGTH)
+
+/******************************************************************************/
+//  TYPEDEF
+/******************************************************************************/
+typedef enum
+{
+    ECC_OK = 0,
+    ECC_CORRECTED,      /* a data bit is corrected */
+    ECC_CODE_ERROR,     /* a bit of code is broken, the data is good */
+    ECC_UNCORRECTABLE
+} ecc_result_t;
+
+/******************************************************************************/
+//  FUNCTIONS
+/******************************************************************************/
+/**
+ * Calculate the code of a buffer, ECC_LENGTH(length) bytes are written to code
+ */
+void ECC_Calculate(const uint8_t * buffer, uint32_t length, uint8_t * code);
+
+/**
+ * Correct a buffer by the code read with it, the worst result of blocks is returned
+ */
+ecc_result_t ECC_Correct(uint8_t * buffer, uint32_t length, const uint8_t * code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UTIL_ECC_H */
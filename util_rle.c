@@ -0,0 +1,130 @@
+/** @file util_rle.c
+ */
+
+/******************************************************************************/
+//  INCLUDE HEADER
+/******************************************************************************/
+#include <string.h>
+#include "util_rle.h"
+
+/******************************************************************************/
+//  MACRO. DEFINE
+/******************************************************************************/
+
+/******************************************************************************/
+//  TYPEDEF
+/******************************************************************************/
+
+/******************************************************************************/
+//  VERIABLES
+/******************************************************************************/
+
+/******************************************************************************/
+//  FUNCTIONS
+/******************************************************************************/
+/**
+ * @brief Count the bytes equal src[0]
+ * 
+ * @param src[in]       The buffer
+ * @param length[in]    Length of buffer 
+ * 
+ * @return The run length, RLE_RUN_MAX at most
+ */
+static uint32_t rle_run(const uint8_t * src, uint32_t length)
+{
+	uint32_t run = 1;
+
+	while ((run < length) && (run < RLE_RUN_MAX) && (src[run] == src[0]))
+	{
+		run++;
+	}
+
+	return run;
+}
+
+/**
+ * Encode a buffer, return the encoded length or 0 if size is not enough
+ */
+uint32_t RLE_Encode(const uint8_t * src, uint32_t length, uint8_t * dst, uint32_t size)
+{
+	uint32_t in = 0, out = 0, literal, run;
+
+	while (in < length)
+	{
+		run = rle_run(src + in, length - in);
+		if (run >= RLE_RUN_MIN)
+		{
+			if ((size - out) < 2)
+			{
+				return 0;
+			}
+			dst[out++] = (uint8_t)(0x80 + run - RLE_RUN_MIN);
+			dst[out++] = src[in];
+			in += run;
+			continue;
+		}
+
+		/* Literal until the next run */
+		literal = run;
+		while (((in + literal) < length) && (literal < RLE_LITERAL_MAX))
+		{
+			if (rle_run(src + in + literal, length - in - literal) >= RLE_RUN_MIN)
+			{
+				break;
+			}
+			literal++;
+		}
+
+		if ((size - out) < (literal + 1))
+		{
+			return 0;
+		}
+		dst[out++] = (uint8_t)(literal - 1);
+		memcpy(dst + out, src + in, literal);
+		out += literal;
+		in += literal;
+	}
+
+	return out;
+}
+
+/**
+ * Decode a buffer, return the decoded length or 0 if the stream is broken
+ * or size is not enough
+ */
+uint32_t RLE_Decode(const uint8_t * src, uint32_t length, uint8_t * dst, uint32_t size)
+{
+	uint32_t in = 0, out = 0, count;
+	uint8_t control;
+
+	while (in < length)
+	{
+		control = src[in++];
+		if (control & 0x80)
+		{
+			count = (control & 0x7F) + RLE_RUN_MIN;
+			if ((in >= length) || ((size - out) < count))
+			{
+				return 0;
+			}
+			memset(dst + out, src[in++], count);
+		}
+		else
+		{
+			count = control + 1;
+			if (((length - in) < count) || ((size - out) < count))
+			{
+				return 0;
+			}
+			memcpy(dst + out, src + in, count);
+			in += count;
+		}
+		out += count;
+	}
+
+	return out;
+}
+
+/******************************************************************************/
+//  END
+/******************************************************************************/
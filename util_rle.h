@@ -0,0 +1,66 @@
+/** @file util_rle.h
+ *  @brief Run length encoding of a small buffer, no RAM is used except the
+ *         source and destination buffers
+ *
+ *  @author tienhuyiot
+ *  @note The stream is a sequence of control byte:
+ *        - 0x00..0x7F: (control + 1) literal bytes follow
+ *        - 0x80..0xFF: one byte follow, repeated (control - 0x80 + 3) times
+ *  @bug No known bugs.
+ *
+ * <pre>
+ * MODIFICATION HISTORY:
+ *
+ * Ver    Who        Date             Changes
+ * -----  --------   ----------       -----------------------------------------------
+ * 1.0    Tienhuyiot Oct 19, 2026     First release
+ *
+ *
+ *</pre>
+ */
+/* MODULE BSP */
+#ifndef __UTIL_RLE_H
+#define __UTIL_RLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+//  INCLUDE HEADER
+/******************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************/
+//  MACRO. DEFINE
+/******************************************************************************/
+/** The shortest run is encoded as a repeat */
+#define RLE_RUN_MIN                         (3)
+/** The longest run of a control byte */
+#define RLE_RUN_MAX                         (0x7F + RLE_RUN_MIN)
+/** The longest literal of a control byte */
+#define RLE_LITERAL_MAX                     (0x80)
+
+/******************************************************************************/
+//  TYPEDEF
+/******************************************************************************/
+
+/******************************************************************************/
+//  FUNCTIONS
+/******************************************************************************/
+/**
+ * Encode a buffer, return the encoded length or 0 if size is not enough
+ */
+uint32_t RLE_Encode(const uint8_t * src, uint32_t length, uint8_t * dst, uint32_t size);
+
+/**
+ * Decode a buffer, return the decoded length or 0 if the stream is broken
+ * or size is not enough
+ */
+uint32_t RLE_Decode(const uint8_t * src, uint32_t length, uint8_t * dst, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UTIL_RLE_H */